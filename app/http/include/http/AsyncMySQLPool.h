@@ -0,0 +1,163 @@
+/**
+ * @file AsyncMySQLPool.h
+ * @brief MySQL connection pool with non-blocking acquire.
+ *
+ * @author Lux
+ */
+
+#pragma once
+
+#include <LuteBase.h>
+#include <LutePolaris.h>
+#include <mysql/mysql.h>
+#include <polaris/EventLoopThread.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Lute {
+namespace http {
+
+    /// acquire() never blocks: the continuation is queued to the caller's
+    /// loop as soon as a connection is free. Waiters are served first come
+    /// first served, and give up after Options::acquireTimeout.
+    ///
+    /// Connecting, pinging and closing run on the pool's own thread. The pool
+    /// keeps between minSize and maxSize connections: idle ones past
+    /// idleTimeout are closed down to minSize, and idle ones unused for
+    /// healthCheckInterval are pinged. Thread safe.
+    class AsyncMySQLPool {
+    public:
+        struct Options {
+            std::string host;
+            uint16_t port = 3306;
+            std::string user;
+            std::string passwd;
+            std::string db;
+            std::string charset = "utf8mb4";
+
+            int minSize = 2;
+            int maxSize = 16;
+            // seconds
+            double acquireTimeout = 1.0;
+            double idleTimeout = 60.0;
+            double healthCheckInterval = 30.0;
+        };
+
+        struct Metrics {
+            int size;
+            int idle;
+            int waiting;
+
+            int64_t acquires;
+            // acquires that found no idle connection
+            int64_t waits;
+            // acquires that found the pool at maxSize
+            int64_t exhaustions;
+            int64_t timeouts;
+            int64_t connectFailures;
+
+            // seconds
+            double totalWait;
+            double maxWait;
+            double totalHold;
+            double maxHold;
+        };
+
+        class Lease;
+        using LeasePtr = std::shared_ptr<Lease>;
+        /// nullptr on timeout or when no connection can be opened.
+        using AcquireCallback = std::function<void(const LeasePtr&)>;
+        /// Called in the pool thread before a connection is closed.
+        using CloseCallback = std::function<void(MYSQL*)>;
+
+        /// A connection out of the pool, given back when destroyed.
+        class Lease {
+            friend class AsyncMySQLPool;
+
+            AsyncMySQLPool* pool_;
+            MYSQL* mysql_;
+            Timestamp acquired_;
+            bool broken_;
+
+        public:
+            Lease(const Lease&) = delete;
+            Lease& operator=(const Lease&) = delete;
+
+            Lease(AsyncMySQLPool* pool, MYSQL* mysql)
+                : pool_(pool),
+                  mysql_(mysql),
+                  acquired_(Timestamp::now()),
+                  broken_(false) {}
+            ~Lease();
+
+            MYSQL* get() const { return mysql_; }
+            /// Closes the connection instead of pooling it, e.g. after
+            /// CR_SERVER_GONE_ERROR.
+            void markBroken() { broken_ = true; }
+        };
+
+        static constexpr double kMaintenanceInterval = 1.0;
+        static constexpr double kMetricsInterval = 60.0;
+
+    private:
+        struct Idle {
+            MYSQL* mysql;
+            Timestamp lastUsed;
+        };
+        struct Waiter {
+            EventLoop* loop;
+            AcquireCallback cb;
+            Timestamp since;
+        };
+
+        const Options options_;
+        CloseCallback closeCallback_;
+        std::unique_ptr<EventLoopThread> thread_;
+        EventLoop* loop_;
+
+        mutable MutexLock mutex_;
+        // most recently used at back
+        std::deque<Idle> idle_ GUARDED_BY(mutex_);
+        std::deque<Waiter> waiters_ GUARDED_BY(mutex_);
+        // open and opening connections
+        int size_ GUARDED_BY(mutex_);
+        Metrics metrics_ GUARDED_BY(mutex_);
+
+        /// In loop_
+        void open();
+        void maintain();
+        void logMetrics();
+
+        void release(MYSQL* mysql, bool broken, double held);
+        /// Gives @c mysql to the first waiter, or makes it idle.
+        void handOff(MYSQL* mysql);
+        void deliver(const Waiter& waiter, MYSQL* mysql);
+        void close(MYSQL* mysql);
+
+    public:
+        AsyncMySQLPool(const AsyncMySQLPool&) = delete;
+        AsyncMySQLPool& operator=(const AsyncMySQLPool&) = delete;
+
+        explicit AsyncMySQLPool(const Options& options);
+        /// Leases must be gone by then.
+        ~AsyncMySQLPool();
+
+        /// E.g. to drop statements prepared on the connection. Once started,
+        /// it is replaced in the pool thread: when this returns, the old
+        /// callback is not running and is never called again.
+        void setCloseCallback(const CloseCallback& cb);
+
+        /// Opens minSize connections in the background.
+        void start();
+
+        /// Queues @c cb to @c loop with a connection.
+        void acquire(EventLoop* loop, AcquireCallback cb);
+
+        Metrics metrics() const;
+    };
+}  // namespace http
+}  // namespace Lute
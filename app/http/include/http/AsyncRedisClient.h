@@ -0,0 +1,116 @@
+/**
+ * @file AsyncRedisClient.h
+ * @brief Non-blocking Redis client on polaris TCPClient.
+ *
+ * @author Lux
+ */
+
+#pragma once
+
+#include <LuteBase.h>
+#include <LutePolaris.h>
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Lute {
+namespace http {
+
+    /// RESP client confined to one EventLoop.
+    ///
+    /// Commands are encoded straight into a pending Buffer, everything issued
+    /// during one loop iteration goes out in a single write, and replies are
+    /// parsed incrementally from the connection's input buffer and matched to
+    /// callbacks in order. Commands issued before the connection is up wait
+    /// in the pending Buffer; when it drops, outstanding callbacks get an
+    /// error reply and the client reconnects.
+    ///
+    /// All calls must be made in the loop thread.
+    class AsyncRedisClient {
+    public:
+        struct Reply {
+            enum Type { kStatus, kError, kInteger, kString, kNil, kArray };
+
+            Type type;
+            // kStatus, kError and kString
+            std::string str;
+            int64_t integer;
+            std::vector<Reply> elements;
+
+            Reply() : type(kNil), integer(0) {}
+
+            bool isError() const { return type == kError; }
+        };
+
+        using ReplyCallback = std::function<void(const Reply&)>;
+        using ConnectCallback = std::function<void(bool connected)>;
+
+        /// Result of parseReply()
+        enum class ParseResult { kOk, kIncomplete, kError };
+
+    private:
+        EventLoop* loop_;
+        TCPClient client_;
+        TCPConnectionPtr conn_;
+        ConnectCallback connectCallback_;
+
+        // encoded commands not written yet
+        Buffer pending_;
+        bool flushQueued_;
+        // one per command sent or pending, in order
+        std::deque<ReplyCallback> callbacks_;
+        // the first numSent_ callbacks_ wait for a reply
+        size_t numSent_;
+
+        void onConnection(const TCPConnectionPtr& conn);
+        void onMessage(const TCPConnectionPtr& conn, Buffer* buf, Timestamp);
+        void flush();
+        void failAll(const std::string& reason);
+
+    public:
+        AsyncRedisClient(const AsyncRedisClient&) = delete;
+        AsyncRedisClient& operator=(const AsyncRedisClient&) = delete;
+
+        AsyncRedisClient(EventLoop* loop, const InetAddress& serverAddr,
+                         const std::string& name = "AsyncRedisClient");
+        ~AsyncRedisClient();
+
+        void setConnectCallback(ConnectCallback cb) {
+            connectCallback_ = std::move(cb);
+        }
+
+        void connect();
+        void disconnect();
+        bool connected() const { return conn_ && conn_->connected(); }
+
+        EventLoop* getLoop() const { return loop_; }
+        /// Commands waiting for a reply
+        size_t outstanding() const { return callbacks_.size(); }
+
+        /// Sends @c args as one command, @c cb may be empty.
+        void command(const std::vector<std::string>& args, ReplyCallback cb);
+
+        void hget(const std::string& key, const std::string& field,
+                  ReplyCallback cb) {
+            command({"HGET", key, field}, std::move(cb));
+        }
+        void hset(const std::string& key, const std::string& field,
+                  const std::string& value, ReplyCallback cb) {
+            command({"HSET", key, field, value}, std::move(cb));
+        }
+        void hexists(const std::string& key, const std::string& field,
+                     ReplyCallback cb) {
+            command({"HEXISTS", key, field}, std::move(cb));
+        }
+
+        /// Appends @c args in RESP to @c buf
+        static void encode(const std::vector<std::string>& args, Buffer* buf);
+
+        /// Parses one reply from [begin, end), on kOk @c *next is past it.
+        static ParseResult parseReply(const char* begin, const char* end,
+                                      Reply* reply, const char** next);
+    };
+}  // namespace http
+}  // namespace Lute
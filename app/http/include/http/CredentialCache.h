@@ -0,0 +1,111 @@
+/**
+ * @file CredentialCache.h
+ * @brief In-process cache of user credentials in front of Redis.
+ *
+ * @author Lux
+ */
+
+#pragma once
+
+#include <LuteBase.h>
+
+#include <array>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Lute {
+namespace http {
+
+    /// username -> password, sharded so IO threads rarely share a lock.
+    ///
+    /// Entries expire after a TTL so changes made behind our back are picked
+    /// up from Redis eventually. Unknown users are cached too, for a shorter
+    /// time, so repeated failed logins do not reach Redis. A full shard
+    /// drops what has expired, then its oldest unknown user, then its oldest
+    /// known one, in O(1). Thread safe.
+    class CredentialCache {
+    public:
+        enum class Lookup { kMiss, kFound, kAbsent };
+        using Clock = Timestamp (*)();
+
+        static const int kNumShards = 16;
+        static const size_t kDefaultMaxEntriesPerShard = 64 * 1024;
+
+    private:
+        struct Entry {
+            std::string username;
+            std::string passwd;
+            Timestamp expiration;
+        };
+        // newest at front; each list has a single TTL, so it is in
+        // expiration order too
+        using ExpiryList = std::list<Entry>;
+        struct Slot {
+            ExpiryList::iterator pos;
+            // false for a negative entry, in Shard::absent
+            bool exists;
+        };
+
+        struct Shard {
+            MutexLock mutex;
+            ExpiryList known GUARDED_BY(mutex);
+            ExpiryList absent GUARDED_BY(mutex);
+            // keys point into Entry::username
+            std::unordered_map<std::string_view, Slot> entries
+                GUARDED_BY(mutex);
+
+            ExpiryList& listOf(bool exists) { return exists ? known : absent; }
+        };
+
+        const double ttl_;
+        const double negativeTtl_;
+        const size_t maxEntriesPerShard_;
+        Clock clock_;
+        std::array<Shard, kNumShards> shards_;
+
+        Shard& shardOf(const std::string& username) {
+            return shards_[std::hash<std::string>()(username) % kNumShards];
+        }
+        /// @return false if @c evict is false and the shard is full
+        bool insert(const std::string& username, const std::string& passwd,
+                    bool exists, double ttl, bool evict);
+        /// Makes room for one more entry, the shard is locked.
+        static bool makeRoom(Shard& shard, Timestamp now, size_t max,
+                             bool evict);
+
+    public:
+        CredentialCache(const CredentialCache&) = delete;
+        CredentialCache& operator=(const CredentialCache&) = delete;
+
+        /// @param ttl seconds a known user is kept
+        /// @param negativeTtl seconds an unknown user is kept
+        CredentialCache(double ttl, double negativeTtl,
+                        size_t maxEntriesPerShard = kDefaultMaxEntriesPerShard);
+
+        /// On kFound the password is stored in @c *passwd.
+        Lookup find(const std::string& username, std::string* passwd);
+
+        void put(const std::string& username, const std::string& passwd) {
+            insert(username, passwd, true, ttl_, true);
+        }
+        /// Like put(), but never evicts a live entry to make room.
+        /// @return false if the shard of @c username is full
+        bool tryPut(const std::string& username, const std::string& passwd) {
+            return insert(username, passwd, true, ttl_, false);
+        }
+        /// Remembers that @c username does not exist.
+        void putAbsent(const std::string& username) {
+            insert(username, std::string(), false, negativeTtl_, true);
+        }
+        void erase(const std::string& username);
+
+        size_t size();
+
+        /// Timestamp::now by default, e.g. a fake one for tests. Not thread
+        /// safe, call before use.
+        void setClock(Clock clock) { clock_ = clock; }
+    };
+}  // namespace http
+}  // namespace Lute
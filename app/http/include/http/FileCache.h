@@ -0,0 +1,138 @@
+/**
+ * @file FileCache.h
+ * @brief In-memory cache of static files, keyed by path.
+ *
+ * @author Lux
+ */
+
+#pragma once
+
+#include <LuteBase.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Lute {
+
+class EventLoop;
+class ThreadPool;
+
+namespace http {
+
+    /// Static asset cache shared by all IO threads.
+    ///
+    /// A hit is served from memory without touching the filesystem, entries
+    /// are revalidated by mtime/size on a timer, and memory is bounded with
+    /// LRU eviction. Thread safe.
+    ///
+    /// Compressible files get gzip/deflate variants built on first access by
+    /// a worker pool; until a variant is ready the identity body is served.
+    class FileCache {
+    public:
+        enum Encoding {
+            kIdentity = 0,
+            kGzip = 1 << 0,
+            kDeflate = 1 << 1,
+        };
+
+        struct File {
+            std::string path;
+            std::string content;
+            // prebuilt header values
+            std::string contentType;
+            std::string lastModified;
+            // strong validator of the identity body, "mtime-size"
+            std::string etag;
+
+            time_t mtime;
+            off_t size;
+            bool compressible;
+            // too big to keep in memory, content is empty and the file is
+            // streamed from disk, never cached
+            bool streamed;
+
+            // built off the IO loop, stored under FileCache::mutex_ with
+            // their bytes, read with std::atomic_load
+            mutable std::shared_ptr<const std::string> gzip;
+            mutable std::shared_ptr<const std::string> deflate;
+            mutable std::atomic<bool> compressing{false};
+        };
+        using FilePtr = std::shared_ptr<const File>;
+
+        static const size_t kDefaultCapacity = 64 * 1024 * 1024;
+
+    private:
+        using LruList = std::list<FilePtr>;
+        struct Entry {
+            FilePtr file;
+            LruList::iterator pos;
+        };
+
+        const size_t capacity_;
+        // not owned, nullptr disables compression
+        ThreadPool* compressPool_;
+
+        mutable MutexLock mutex_;
+        // most recently used at front
+        LruList lru_ GUARDED_BY(mutex_);
+        // keys point into Entry::file->path
+        std::unordered_map<std::string_view, Entry> entries_ GUARDED_BY(mutex_);
+        size_t bytes_ GUARDED_BY(mutex_);
+
+        void insert(const FilePtr& file);
+        void evictIfNeeded();
+        void compressAsync(const FilePtr& file);
+
+        /// Builds the variants of @c file, off the lock.
+        static void compress(const File& file,
+                             std::shared_ptr<const std::string>* gzip,
+                             std::shared_ptr<const std::string>* deflate);
+
+    public:
+        // noncopyable
+        FileCache(const FileCache&) = delete;
+        FileCache& operator=(const FileCache&) = delete;
+
+        explicit FileCache(size_t capacity = kDefaultCapacity);
+
+        /// Returns the cached file, loading it on miss.
+        /// Returns nullptr if not exist, not readable or a directory.
+        FilePtr get(std::string_view path);
+
+        /// Must be called before serving, @c pool runs the compression.
+        void setCompressPool(ThreadPool* pool) { compressPool_ = pool; }
+
+        /// Loads every regular file in @c dir, and schedules its compression.
+        void preload(const std::string& dir);
+
+        /// Returns the body of @c file in the best encoding that is both
+        /// @c accepted (bitmask of Encoding) and ready, which is stored in
+        /// @c *encoding.
+        std::shared_ptr<const std::string> body(const FilePtr& file,
+                                                int accepted,
+                                                Encoding* encoding);
+
+        /// Drops entries whose mtime or size changed on disk.
+        void revalidate();
+
+        /// Runs revalidate() every @c interval seconds in @c loop.
+        void startRevalidate(EventLoop* loop, double interval);
+
+        size_t bytes() const;
+        size_t size() const;
+
+        /// Loads @c path from disk, bypassing the cache.
+        /// Files over @c maxContentSize are not read, see File::streamed.
+        static FilePtr load(const std::string& path, size_t maxContentSize);
+        static const char* mimeType(const std::string& path);
+        /// Parses the Accept-Encoding header, returns a bitmask of Encoding.
+        static int acceptedEncodings(std::string_view acceptEncoding);
+        static const char* encodingName(Encoding encoding);
+    };
+}  // namespace http
+}  // namespace Lute
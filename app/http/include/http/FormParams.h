@@ -0,0 +1,94 @@
+/**
+ * @file FormParams.h
+ * @brief application/x-www-form-urlencoded and query string parser.
+ *
+ * @author Lux
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace Lute {
+namespace http {
+
+    /// Decoded "key=value&key=value" pairs, e.g. a query string or a
+    /// urlencoded POST body.
+    ///
+    /// The input is copied once and percent-decoded in place ('+' is a
+    /// space), fields are kept as offsets into that copy, so lookups return
+    /// views and never allocate. Delimiters are split before decoding, so an
+    /// encoded "%26" or "%3D" stays in the value.
+    class FormParams {
+    public:
+        static const int kMaxFields = 32;
+
+    private:
+        struct Field {
+            uint32_t key;
+            uint32_t keyLen;
+            uint32_t value;
+            uint32_t valueLen;
+        };
+
+        std::pmr::string data_;
+        std::array<Field, kMaxFields> fields_;
+        int size_;
+
+        std::string_view view(uint32_t offset, uint32_t len) const {
+            return std::string_view(data_.data() + offset, len);
+        }
+
+    public:
+        using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+        explicit FormParams(allocator_type alloc = allocator_type())
+            : data_(alloc), size_(0) {}
+        FormParams(const FormParams& that, allocator_type alloc)
+            : data_(that.data_, alloc),
+              fields_(that.fields_),
+              size_(that.size_) {}
+
+        /// Parses [begin, end), a leading '?' is skipped.
+        /// @return false if there are more than kMaxFields fields, the first
+        /// kMaxFields are kept.
+        bool parse(const char* begin, const char* end);
+
+        void clear() {
+            data_.clear();
+            size_ = 0;
+        }
+
+        int size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        std::string_view key(int i) const {
+            const Field& f = fields_[static_cast<size_t>(i)];
+            return view(f.key, f.keyLen);
+        }
+        std::string_view value(int i) const {
+            const Field& f = fields_[static_cast<size_t>(i)];
+            return view(f.value, f.valueLen);
+        }
+
+        /// First value of @c key, empty view if absent.
+        std::string_view get(std::string_view key) const;
+        bool has(std::string_view key) const;
+
+        void swap(FormParams& that) {
+            data_.swap(that.data_);
+            fields_.swap(that.fields_);
+            std::swap(size_, that.size_);
+        }
+
+        /// Percent-decodes [begin, end) in place, '+' becomes a space and
+        /// malformed escapes are kept as is.
+        /// @return the decoded length
+        static size_t decode(char* begin, char* end);
+    };
+}  // namespace http
+}  // namespace Lute
@@ -6,8 +6,15 @@
  */
 
 #include <http/HttpRequest.h>
+#include <http/HttpResponse.h>
+#include <http/RequestArena.h>
 #include <polaris/Buffer.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
 namespace Lute {
 namespace http {
 class HttpContext {
@@ -21,29 +28,117 @@ public:
 
 private:
     HttpRequestParseState state_;
-    HttpRequest request_;
+    // a larger Content-Length is refused with 413
+    size_t maxBodySize_;
+    // why parseRequest() failed
+    HttpResponse::HttpStatusCode error_;
+    // shared by copies, a context is copied once into the connection
+    std::shared_ptr<RequestArena> arena_;
+    // from arena_, rebuilt by reset()
+    std::optional<HttpRequest> request_;
+    // a deferred response is not sent yet, the next request waits in the
+    // input buffer or the socket, which is not read meanwhile, to keep
+    // responses in order
+    bool pending_;
+    // body of the response being streamed, see HttpResponse::setBodyStream()
+    HttpResponse::BodyProducer producer_;
+    // as announced by the headers, -1 if unknown
+    int64_t streamLength_;
+    int64_t streamSent_;
+    bool chunked_;
+    bool closeAfterStream_;
+    // seconds until a producer with nothing ready is polled again, 0 if
+    // the last poll got a piece
+    double streamRetryDelay_;
 
     bool processRequestLine(const char* begin, const char* end);
 
 public:
-    HttpContext() : state_(HttpRequestParseState::kExpectRequestLine) {}
+    HttpContext()
+        : state_(HttpRequestParseState::kExpectRequestLine),
+          maxBodySize_(SIZE_MAX),
+          error_(HttpResponse::HttpStatusCode::kUnknown),
+          arena_(std::make_shared<RequestArena>()),
+          request_(std::in_place, arena_->allocator()),
+          pending_(false),
+          streamLength_(-1),
+          streamSent_(0),
+          chunked_(false),
+          closeAfterStream_(false),
+          streamRetryDelay_(0) {}
 
-    // default copy-ctor, dtor and assignment are fine
+    HttpContext(const HttpContext& that)
+        : state_(that.state_),
+          maxBodySize_(that.maxBodySize_),
+          error_(that.error_),
+          arena_(that.arena_),
+          request_(std::in_place, *that.request_, arena_->allocator()),
+          pending_(that.pending_),
+          producer_(that.producer_),
+          streamLength_(that.streamLength_),
+          streamSent_(that.streamSent_),
+          chunked_(that.chunked_),
+          closeAfterStream_(that.closeAfterStream_),
+          streamRetryDelay_(that.streamRetryDelay_) {}
+    HttpContext& operator=(const HttpContext&) = delete;
 
-    // return false if any error
+    // return false if any error, see error()
     bool parseRequest(Lute::Buffer* buf, Timestamp receiveTime);
+    /// k400BadRequest, or k413PayloadTooLarge past setMaxBodySize().
+    HttpResponse::HttpStatusCode error() const { return error_; }
+
+    /// Bodies are buffered whole, this bounds what a request can pin.
+    void setMaxBodySize(size_t bytes) { maxBodySize_ = bytes; }
 
     bool gotAll() const { return state_ == HttpRequestParseState::kGotAll; }
 
+    /// After the response is written, anything from allocator() must be
+    /// gone by then.
     void reset() {
         state_ = HttpRequestParseState::kExpectRequestLine;
-        HttpRequest dummy;
-        request_.swap(dummy);
+        request_.reset();
+        arena_->release();
+        request_.emplace(arena_->allocator());
+    }
+
+    /// For the response to the current request.
+    RequestArena::allocator_type allocator() { return arena_->allocator(); }
+
+    void setPending(bool on) { pending_ = on; }
+    bool pending() const { return pending_; }
+
+    void startStream(HttpResponse::BodyProducer producer, int64_t length,
+                     bool chunked, bool close) {
+        producer_ = std::move(producer);
+        streamLength_ = length;
+        streamSent_ = 0;
+        chunked_ = chunked;
+        closeAfterStream_ = close;
+        streamRetryDelay_ = 0;
+    }
+    void stopStream() { producer_ = HttpResponse::BodyProducer(); }
+    bool streaming() const { return static_cast<bool>(producer_); }
+    const HttpResponse::BodyProducer& producer() const { return producer_; }
+    int64_t streamLength() const { return streamLength_; }
+    int64_t streamSent() const { return streamSent_; }
+    void streamed(size_t len) {
+        streamSent_ += static_cast<int64_t>(len);
+        streamRetryDelay_ = 0;
+    }
+    /// Delay before polling a producer that had nothing ready, @c first
+    /// after a piece, then doubling up to @c max.
+    double backOffStream(double first, double max) {
+        streamRetryDelay_ = streamRetryDelay_ > 0
+                                ? std::min(2 * streamRetryDelay_, max)
+                                : first;
+        return streamRetryDelay_;
     }
+    bool chunked() const { return chunked_; }
+    bool closeAfterStream() const { return closeAfterStream_; }
 
-    const HttpRequest& request() const { return request_; }
+    const HttpRequest& request() const { return *request_; }
 
-    HttpRequest& request() { return request_; }
+    HttpRequest& request() { return *request_; }
 };
 }  // namespace http
 }  // namespace Lux
@@ -0,0 +1,36 @@
+/**
+ * @file HttpRange.h
+ * @brief Validators and byte ranges of static file responses.
+ *
+ * @author Lux
+ */
+
+#pragma once
+
+#include <ctime>
+#include <string_view>
+
+namespace Lute {
+namespace http {
+
+    /// Parses an IMF-fixdate, returns -1 if malformed.
+    time_t parseHttpDate(std::string_view date);
+
+    /// If-None-Match: "a", W/"b" or *, weak comparison against @c etag.
+    bool etagMatches(std::string_view ifNoneMatch, std::string_view etag);
+
+    /// If-Range: the range applies only to the representation it names, by
+    /// strong comparison of its entity tag or its exact Last-Modified date.
+    /// True for an empty @c ifRange.
+    bool ifRangeMatches(std::string_view ifRange, std::string_view etag,
+                        std::string_view lastModified);
+
+    enum class RangeResult { kNone, kSatisfiable, kUnsatisfiable };
+
+    /// Single byte range only, "bytes=0-499", "bytes=500-" or "bytes=-500",
+    /// of a body of @c size bytes. Malformed and multiple ranges are
+    /// kNone, the full body is sent.
+    RangeResult parseRange(std::string_view range, size_t size,
+                           size_t* offset, size_t* len);
+}  // namespace http
+}  // namespace Lute
@@ -8,8 +8,12 @@
 #pragma once
 
 #include <LuteBase.h>
+#include <http/FormParams.h>
 
 #include <map>
+#include <memory_resource>
+#include <string>
+#include <string_view>
 
 namespace Lute {
 namespace http {
@@ -18,18 +22,48 @@ public:
     enum class Method { kInvalid, kGet, kPost, kHead, kPut, kDelete };
     enum class Version { kUnknown, kHttp10, kHttp11 };
 
+    /// Where the strings and the header map live, e.g. RequestArena.
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+    // std::less<> looks up by string_view
+    using Headers =
+        std::pmr::map<std::pmr::string, std::pmr::string, std::less<>>;
+
 private:
     Method method_;
     Version version_;
 
-    std::string path_;
-    std::string query_;
+    std::pmr::string path_;
+    std::pmr::string query_;
     Timestamp receiveTime_;
-    std::map<std::string, std::string> headers_;
-    std::string body_;
+    Headers headers_;
+    std::pmr::string body_;
+    FormParams queryParams_;
+    FormParams formParams_;
 
 public:
-    HttpRequest() : method_(Method::kInvalid), version_(Version::kUnknown) {}
+    explicit HttpRequest(allocator_type alloc = allocator_type())
+        : method_(Method::kInvalid),
+          version_(Version::kUnknown),
+          path_(alloc),
+          query_(alloc),
+          headers_(alloc),
+          body_(alloc),
+          queryParams_(alloc),
+          formParams_(alloc) {}
+
+    /// Copies @c that into @c alloc, e.g. out of a connection's arena.
+    HttpRequest(const HttpRequest& that, allocator_type alloc)
+        : method_(that.method_),
+          version_(that.version_),
+          path_(that.path_, alloc),
+          query_(that.query_, alloc),
+          receiveTime_(that.receiveTime_),
+          headers_(that.headers_, alloc),
+          body_(that.body_, alloc),
+          queryParams_(that.queryParams_, alloc),
+          formParams_(that.formParams_, alloc) {}
+
+    allocator_type get_allocator() const { return path_.get_allocator(); }
 
     void setVersion(Version v) { version_ = v; }
     Version getVersion() const { return version_; }
@@ -39,7 +73,7 @@ public:
         assert(method_ == Method::kInvalid);
 #endif
 
-        std::string m(start, end);
+        const std::string_view m(start, static_cast<size_t>(end - start));
         if (m == "GET")
             method_ = Method::kGet;
         else if (m == "POST")
@@ -87,41 +121,66 @@ public:
     void setPath(const char* start, const char* end) {
         path_.assign(start, end);
     }
-    const std::string& path() const { return path_; }
+    std::string_view path() const { return path_; }
 
     void setQuery(const char* start, const char* end) {
         query_.assign(start, end);
+        queryParams_.parse(start, end);
+    }
+    std::string_view query() const { return query_; }
+    const FormParams& queryParams() const { return queryParams_; }
+    /// Decoded query string field, empty if absent.
+    std::string_view queryParam(std::string_view key) const {
+        return queryParams_.get(key);
     }
-    const std::string& query() const { return query_; }
 
     void setReceiveTime(Timestamp t) { receiveTime_ = t; }
     Timestamp receiveTime() const { return receiveTime_; }
 
     // key: value
     void addHeader(const char* start, const char* colon, const char* end) {
-        std::string field(start, colon);
+        const std::string_view field(start,
+                                     static_cast<size_t>(colon - start));
         ++colon;
         while (colon < end && isspace(*colon)) ++colon;
+        while (end > colon && isspace(*(end - 1))) --end;
 
-        std::string value(colon, end);
-        while (!value.empty() && isspace(value[value.size() - 1]))
-            value.resize(value.size() - 1);
-        headers_[field] = value;
+        const std::string_view value(colon, static_cast<size_t>(end - colon));
+        auto iter = headers_.find(field);
+        if (iter != headers_.end()) {
+            iter->second.assign(value);
+        } else {
+            headers_.emplace(field, value);
+        }
     }
-    std::string getHeader(const std::string& field) const {
-        // string result;
+    /// Empty if absent, valid as long as the request.
+    std::string_view getHeader(std::string_view field) const {
         auto iter = headers_.find(field);
-        // if (iter != headers_.end()) result = iter->second;
-        // return result;
+        return iter != headers_.end() ? std::string_view(iter->second)
+                                      : std::string_view();
+    }
+    const Headers& headers() const { return headers_; }
 
-        return iter != headers_.end() ? iter->second : "";
+    void setBody(const char* begin, const char* end) {
+        body_.assign(begin, end);
     }
-    const std::map<std::string, std::string>& headers() const { return headers_; }
+    std::string_view body() const { return body_; }
 
-    void setBody(const std::string& body) { body_ = body; }
-    std::string body() const { return body_; }
+    /// Parses the body if it is application/x-www-form-urlencoded.
+    void parseFormBody() {
+        const std::string_view type = getHeader("Content-Type");
+        if (type.compare(0, 33, "application/x-www-form-urlencoded") == 0)
+            formParams_.parse(body_.data(), body_.data() + body_.size());
+    }
+    const FormParams& formParams() const { return formParams_; }
+    /// Decoded urlencoded body field, empty if absent.
+    std::string_view formParam(std::string_view key) const {
+        return formParams_.get(key);
+    }
 
+    /// Both must use the same allocator.
     void swap(HttpRequest& that) {
+        assert(get_allocator() == that.get_allocator());
         std::swap(method_, that.method_);
         std::swap(version_, that.version_);
         path_.swap(that.path_);
@@ -129,6 +188,8 @@ public:
         receiveTime_.swap(that.receiveTime_);
         headers_.swap(that.headers_);
         body_.swap(that.body_);
+        queryParams_.swap(that.queryParams_);
+        formParams_.swap(that.formParams_);
     }
 };
 }  // namespace http
@@ -10,51 +10,201 @@
 #include <LuteBase.h>
 #include <LutePolaris.h>
 
+#include <functional>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
 
 namespace Lute {
 namespace http {
+class HttpRequest;
+
 class HttpResponse {
 public:
     enum class HttpStatusCode {
         kUnknown,
         k200Ok = 200,
+        k206PartialContent = 206,
         k301MovedPermanently = 301,
+        k304NotModified = 304,
         k400BadRequest = 400,
         k404NotFound = 404,
+        k413PayloadTooLarge = 413,
+        k416RangeNotSatisfiable = 416,
+        k503ServiceUnavailable = 503,
     };
 
+    /// Blocking part of a handler, run off the IO loop, see defer().
+    using DeferredCallback =
+        std::function<void(const HttpRequest&, HttpResponse*)>;
+    /// Completes a response, call exactly once, from any thread.
+    using Done = std::function<void()>;
+    /// Non-blocking part of a handler, run in the IO loop, see deferInLoop().
+    using AsyncCallback =
+        std::function<void(const HttpRequest&, HttpResponse*, const Done&)>;
+    /// Appends the next piece of a streamed body to @c buf, returns false
+    /// after the last one. Returning true with nothing appended asks to be
+    /// called again a little later, see HttpServer::kStreamRetryDelay.
+    using BodyProducer = std::function<bool(Lute::Buffer* buf)>;
+
+    /// What a BodyProducer should append at a time.
+    static const size_t kStreamPieceSize = 64 * 1024;
+
+    /// Where the strings and the header map live, e.g. RequestArena.
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+    using Headers =
+        std::pmr::map<std::pmr::string, std::pmr::string, std::less<>>;
+
 private:
-    std::map<std::string, std::string> headers_;
+    Headers headers_;
     HttpStatusCode statusCode_;
     // FIXME: add http version
-    std::string statusMessage_;
+    std::pmr::string statusMessage_;
     bool closeConnection_;
-    std::string body_;
+    // the answer to a HEAD request
+    bool headersOnly_;
+    std::pmr::string body_;
+    // shared with FileCache, [bodyOffset_, bodyOffset_ + bodyLen_) is sent
+    std::shared_ptr<const std::string> sharedBody_;
+    size_t bodyOffset_;
+    size_t bodyLen_;
+    DeferredCallback deferred_;
+    AsyncCallback async_;
+    BodyProducer producer_;
+    // -1 if unknown
+    int64_t streamLength_;
 
 public:
-    explicit HttpResponse(bool close)
-        : statusCode_(HttpStatusCode::kUnknown), closeConnection_(close) {}
+    explicit HttpResponse(bool close, allocator_type alloc = allocator_type())
+        : headers_(alloc),
+          statusCode_(HttpStatusCode::kUnknown),
+          statusMessage_(alloc),
+          closeConnection_(close),
+          headersOnly_(false),
+          body_(alloc),
+          bodyOffset_(0),
+          bodyLen_(0),
+          streamLength_(-1) {}
+
+    /// Copies @c that into @c alloc, e.g. out of a connection's arena.
+    HttpResponse(const HttpResponse& that, allocator_type alloc)
+        : headers_(that.headers_, alloc),
+          statusCode_(that.statusCode_),
+          statusMessage_(that.statusMessage_, alloc),
+          closeConnection_(that.closeConnection_),
+          headersOnly_(that.headersOnly_),
+          body_(that.body_, alloc),
+          sharedBody_(that.sharedBody_),
+          bodyOffset_(that.bodyOffset_),
+          bodyLen_(that.bodyLen_),
+          deferred_(that.deferred_),
+          async_(that.async_),
+          producer_(that.producer_),
+          streamLength_(that.streamLength_) {}
 
     void setStatusCode(HttpStatusCode code) { statusCode_ = code; }
+    HttpStatusCode statusCode() const { return statusCode_; }
 
-    void setStatusMessage(const std::string& message) { statusMessage_ = message; }
+    void setStatusMessage(std::string_view message) {
+        statusMessage_.assign(message);
+    }
 
     void setCloseConnection(bool on) { closeConnection_ = on; }
 
     bool closeConnection() const { return closeConnection_; }
 
-    void setContentType(const std::string& contentType) {
+    /// Sends the headers, Content-Length included, as for a GET, and no
+    /// body. HttpServer sets it for HEAD requests before the handler runs.
+    void setHeadersOnly(bool on) { headersOnly_ = on; }
+    bool headersOnly() const { return headersOnly_; }
+
+    void setContentType(std::string_view contentType) {
         addHeader("Content-Type", contentType);
     }
 
-    // FIXME: replace string with StringPiece
-    void addHeader(const std::string& key, const std::string& value) {
-        headers_[key] = value;
+    void addHeader(std::string_view key, std::string_view value) {
+        auto iter = headers_.find(key);
+        if (iter != headers_.end()) {
+            iter->second.assign(value);
+        } else {
+            headers_.emplace(key, value);
+        }
+    }
+
+    void setBody(std::string_view body) {
+        body_.assign(body);
+        sharedBody_.reset();
+    }
+
+    void setBody(std::shared_ptr<const std::string> body) {
+        size_t len = body ? body->size() : 0;
+        setBody(std::move(body), 0, len);
     }
 
-    void setBody(const std::string& body) { body_ = body; }
+    /// Sends @c len bytes of @c body starting at @c offset, e.g. for a Range.
+    void setBody(std::shared_ptr<const std::string> body, size_t offset,
+                 size_t len) {
+        body_.clear();
+        sharedBody_ = std::move(body);
+        bodyOffset_ = offset;
+        bodyLen_ = len;
+    }
+
+    /// Streams the body: the headers are sent at once, then HttpServer
+    /// pulls the body from @c producer a piece at a time, whenever the
+    /// previous piece has been written to the socket. An unknown @c length
+    /// is sent chunked, or until close to an HTTP/1.0 client. @c producer
+    /// runs in the IO loop, after the request and this response are gone.
+    void setBodyStream(BodyProducer producer, int64_t length = -1) {
+        body_.clear();
+        sharedBody_.reset();
+        producer_ = std::move(producer);
+        streamLength_ = length;
+    }
+    bool streaming() const { return static_cast<bool>(producer_); }
+    int64_t streamLength() const { return streamLength_; }
+    /// Chunked transfer coding is used for the streamed body.
+    bool chunked() const {
+        return streaming() && streamLength_ < 0 && !closeConnection_;
+    }
+    BodyProducer takeBodyStream() {
+        BodyProducer producer;
+        producer.swap(producer_);
+        return producer;
+    }
+
+    const char* bodyData() const {
+        return sharedBody_ ? sharedBody_->data() + bodyOffset_ : body_.data();
+    }
+    size_t bodySize() const { return sharedBody_ ? bodyLen_ : body_.size(); }
+    bool hasSharedBody() const { return static_cast<bool>(sharedBody_); }
+
+    /// Marks the response pending: HttpServer runs @c cb on its worker pool
+    /// with this response, and sends it from the connection's loop once
+    /// @c cb returns. @c cb must capture nothing owned by the IO loop.
+    void defer(DeferredCallback cb) { deferred_ = std::move(cb); }
+    /// Like defer(), but @c cb runs in the IO loop right after the handler,
+    /// e.g. to start async IO, and the response is sent once done() is
+    /// called. The request and response stay alive until then.
+    void deferInLoop(AsyncCallback cb) { async_ = std::move(cb); }
+    bool deferred() const {
+        return static_cast<bool>(deferred_) || static_cast<bool>(async_);
+    }
+    DeferredCallback takeDeferred() {
+        DeferredCallback cb;
+        cb.swap(deferred_);
+        return cb;
+    }
+    AsyncCallback takeAsync() {
+        AsyncCallback cb;
+        cb.swap(async_);
+        return cb;
+    }
 
+    /// Status line and headers, without body.
+    void appendHeadersToBuffer(Lute::Buffer* output) const;
     void appendToBuffer(Lute::Buffer* output) const;
 };
 }  // namespace http
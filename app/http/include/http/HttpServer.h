@@ -12,6 +12,9 @@
 #include <functional>
 
 namespace Lute {
+
+class ThreadPool;
+
 namespace http {
 
     class HttpResponse;
@@ -21,6 +24,13 @@ namespace http {
     /// It is not a fully HTTP 1.1 compliant server, but provides minimum
     /// features that can communicate with HttpClient and Web browser. It is
     /// synchronous, just like Java Servlet.
+    ///
+    /// A handler with blocking work calls HttpResponse::defer(), the work then
+    /// runs on the worker pool and the response is sent from the connection's
+    /// loop afterwards. One with async work calls HttpResponse::deferInLoop()
+    /// and completes the response later. Further requests on that connection
+    /// wait until it is sent, the connection does not read meanwhile. Past
+    /// maxPending deferred requests new ones get 503 at once.
     class HttpServer {
         HttpServer(const HttpServer&) = delete;
         HttpServer& operator=(HttpServer&) = delete;
@@ -29,9 +39,33 @@ namespace http {
         using HttpCallback =
             std::function<void(const HttpRequest&, HttpResponse*)>;
 
+        /// Shared bodies from this size on are not copied into the header
+        /// buffer, smaller ones go out with the headers in a single write.
+        static const size_t kZeroCopyBodySize = 16 * 1024;
+        static const int kDefaultMaxPending = 1024;
+        /// Request bodies are buffered whole, larger ones get 413.
+        static const size_t kDefaultMaxBodySize = 1024 * 1024;
+        /// A streamed body is not pulled while this much is still queued
+        /// in the connection's output buffer.
+        static const size_t kStreamHighWaterMark = 256 * 1024;
+        /// A producer with nothing ready is polled again after this many
+        /// seconds, doubling while it stays dry, up to kStreamMaxRetryDelay.
+        static constexpr double kStreamRetryDelay = 0.001;
+        static constexpr double kStreamMaxRetryDelay = 0.1;
+        /// A connection stops reading requests while this much of its
+        /// responses is unsent, and reads again at kDefaultFlowLowMark.
+        /// Above kStreamHighWaterMark plus a piece, so streams never trip it.
+        static const size_t kDefaultFlowHighMark = 1024 * 1024;
+        static const size_t kDefaultFlowLowMark = 256 * 1024;
+
     private:
         TCPServer server_;
         HttpCallback httpCallback_;
+        // not owned, nullptr runs deferred work in the IO loop
+        ThreadPool* workerPool_;
+        int maxPending_;
+        size_t maxBodySize_;
+        AtomicInt32 numPending_;
 
     public:
         HttpServer(EventLoop* loop, const InetAddress& listenAddr,
@@ -45,6 +79,26 @@ namespace http {
 
         void setThreadNum(int numThreads) { server_.setThreadNum(numThreads); }
 
+        /// Runs in each IO thread before its loop starts.
+        void setThreadInitCallback(const TCPServer::ThreadInitCallback& cb) {
+            server_.setThreadInitCallback(cb);
+        }
+
+        /// Not thread safe, @c pool must outlive the connections.
+        void setWorkerPool(ThreadPool* pool) { workerPool_ = pool; }
+        void setMaxPending(int maxPending) { maxPending_ = maxPending; }
+        int numPending() { return numPending_.get(); }
+        /// Not thread safe, for connections accepted afterwards.
+        void setMaxBodySize(size_t bytes) { maxBodySize_ = bytes; }
+        /// See TCPConnection::setFlowControl, 0 turns it off.
+        void setFlowControl(size_t highMark, size_t lowMark) {
+            server_.setFlowControl(highMark, lowMark);
+        }
+        /// See TCPServer::setBusyPoll, before start().
+        void setBusyPoll(int us) { server_.setBusyPoll(us); }
+        /// See TCPServer::setLoopConfined, before start().
+        void setLoopConfined(bool on) { server_.setLoopConfined(on); }
+
         void start();
 
     private:
@@ -52,8 +106,16 @@ namespace http {
         void onMessage(const TCPConnectionPtr& conn,
                        Buffer* buf, Timestamp);
         void onWriteCompleteCallback(const TCPConnectionPtr& conn);
-        void onRequest(const TCPConnectionPtr& conn,
-                       const HttpRequest&);
+        void onRequest(const TCPConnectionPtr& conn, HttpRequest& req);
+        void runDeferred(const TCPConnectionPtr& conn, HttpRequest& req,
+                         HttpResponse& response);
+        void onDeferredDone(const TCPConnectionPtr& conn,
+                            const std::shared_ptr<HttpResponse>& response);
+        void sendResponse(const TCPConnectionPtr& conn,
+                          HttpResponse& response);
+        /// Sends the next piece of a streamed body.
+        void pumpStream(const TCPConnectionPtr& conn);
+        void finishStream(const TCPConnectionPtr& conn);
     };
 }  // namespace http
 }  // namespace Lute
\ No newline at end of file
@@ -0,0 +1,46 @@
+/**
+ * @file RequestArena.h
+ * @brief Per-connection memory for the request in flight.
+ *
+ * @author Lux
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace Lute {
+namespace http {
+
+    /// Monotonic arena the request and response of a connection allocate
+    /// from: strings, header maps and parsed fields. Nothing is freed one by
+    /// one, release() rewinds the whole arena once the response has been
+    /// written to the connection.
+    ///
+    /// kInitialSize bytes are inline, which covers the headers of a typical
+    /// browser request; more comes from the default resource in growing
+    /// chunks and is returned by release(). Confined to the connection's loop.
+    class RequestArena {
+    public:
+        static const size_t kInitialSize = 4096;
+
+        using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    private:
+        char initial_[kInitialSize];
+        std::pmr::monotonic_buffer_resource resource_;
+
+    public:
+        RequestArena(const RequestArena&) = delete;
+        RequestArena& operator=(const RequestArena&) = delete;
+
+        RequestArena() : resource_(initial_, sizeof(initial_)) {}
+
+        allocator_type allocator() { return allocator_type(&resource_); }
+
+        /// Everything allocated from the arena must be destroyed by then.
+        void release() { resource_.release(); }
+    };
+}  // namespace http
+}  // namespace Lute
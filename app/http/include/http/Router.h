@@ -0,0 +1,129 @@
+/**
+ * @file Router.h
+ * @brief Maps request method and path to a handler.
+ *
+ * @author Lux
+ */
+
+#pragma once
+
+#include <http/HttpRequest.h>
+
+#include <array>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Lute {
+namespace http {
+
+    class HttpResponse;
+
+    /// Routes are looked up in this order:
+    ///  - exact paths, e.g. "/register", by hash
+    ///  - patterns, e.g. "/user/:id" or "/static/*path", by a segment trie;
+    ///    static segments win over ":param", which wins over "*rest"
+    ///  - extensions, e.g. ".jpg", for static files
+    ///
+    /// Lookup is O(path length) and does not allocate, matched parameters are
+    /// views into HttpRequest::path(), valid during the handler call.
+    ///
+    /// Not thread safe for add*(), which must be done before serving;
+    /// route() is const and can be called from all IO threads.
+    class Router {
+    public:
+        static const int kMaxParams = 8;
+
+        class Params {
+            friend class Router;
+
+            struct Param {
+                std::string_view name;
+                std::string_view value;
+            };
+            std::array<Param, kMaxParams> params_;
+            int size_;
+
+            void push(std::string_view name, std::string_view value) {
+                params_[static_cast<size_t>(size_++)] = Param{name, value};
+            }
+
+        public:
+            Params() : size_(0) {}
+
+            int size() const { return size_; }
+            /// Empty view if there is no such parameter.
+            std::string_view get(std::string_view name) const {
+                for (int i = 0; i < size_; ++i) {
+                    const Param& p = params_[static_cast<size_t>(i)];
+                    if (p.name == name) return p.value;
+                }
+                return std::string_view();
+            }
+        };
+
+        using Handler = std::function<void(const HttpRequest&, const Params&,
+                                           HttpResponse*)>;
+
+    private:
+        static const size_t kNumMethods =
+            static_cast<size_t>(HttpRequest::Method::kDelete) + 1;
+
+        /// One handler per method
+        struct Route {
+            std::array<Handler, kNumMethods> handlers;
+
+            const Handler* find(HttpRequest::Method method) const;
+        };
+
+        struct Node {
+            std::string segment;
+            // static children, usually a handful, scanned linearly
+            std::vector<std::unique_ptr<Node>> children;
+            std::unique_ptr<Node> param;
+            std::string paramName;
+            std::unique_ptr<Node> wildcard;
+            std::string wildcardName;
+
+            std::unique_ptr<Route> route;
+        };
+
+        // keys point into patterns_, so lookups take the request's view
+        std::unordered_map<std::string_view, Route> exact_;
+        std::list<std::string> patterns_;
+        Node root_;
+        std::vector<std::pair<std::string, Route>> extensions_;
+        Handler notFound_;
+
+        bool match(const Node* node, std::string_view path,
+                   HttpRequest::Method method, Params* params,
+                   const Handler** handler) const;
+        const Route* findExtension(std::string_view path) const;
+
+    public:
+        Router() = default;
+        // noncopyable
+        Router(const Router&) = delete;
+        Router& operator=(const Router&) = delete;
+
+        /// @param pattern "/exact", "/user/:id" or "/files/*path"
+        void add(HttpRequest::Method method, const std::string& pattern,
+                 Handler handler);
+
+        /// @param extension e.g. ".jpg", matched at the end of the path
+        void addExtension(HttpRequest::Method method,
+                          const std::string& extension, Handler handler);
+
+        void setNotFound(Handler handler) { notFound_ = std::move(handler); }
+
+        /// Calls the handler matching @c req.
+        /// @return false if no route matched, after calling the not found
+        /// handler if any.
+        bool route(const HttpRequest& req, HttpResponse* resp) const;
+    };
+}  // namespace http
+}  // namespace Lute
@@ -0,0 +1,71 @@
+/**
+ * @file ScratchArena.h
+ * @brief Per-thread bump allocator for request temporaries.
+ *
+ * @author Lux
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Lute {
+namespace http {
+
+    /// Handlers build paths and other temporaries here instead of in shared
+    /// members or on the heap. Every thread has its own arena, a Scope gives
+    /// back everything allocated since it was opened, so a request does not
+    /// free piecemeal and the next one starts from the same spot.
+    ///
+    /// What does not fit in the kSize buffer comes from the heap and is
+    /// freed when the outermost Scope closes. Not thread safe: memory must
+    /// not leave the thread, nor outlive its Scope.
+    class ScratchArena {
+    public:
+        static const size_t kSize = 16 * 1024;
+
+        /// Rewinds the arena of the calling thread when destroyed.
+        class Scope {
+            ScratchArena& arena_;
+            const size_t mark_;
+
+        public:
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            Scope() : arena_(current()), mark_(arena_.used_) {}
+            ~Scope() { arena_.rewind(mark_); }
+
+            ScratchArena& arena() const { return arena_; }
+        };
+
+    private:
+        char buffer_[kSize];
+        size_t used_;
+        std::vector<std::unique_ptr<char[]>> overflow_;
+
+        ScratchArena() : used_(0) {}
+
+        void rewind(size_t mark);
+
+    public:
+        ScratchArena(const ScratchArena&) = delete;
+        ScratchArena& operator=(const ScratchArena&) = delete;
+
+        /// The arena of the calling thread.
+        static ScratchArena& current();
+
+        char* allocate(size_t n, size_t align = alignof(std::max_align_t));
+
+        /// Joins @c parts, the result is NUL terminated for C APIs.
+        std::string_view concat(std::initializer_list<std::string_view> parts);
+
+        size_t used() const { return used_; }
+        size_t overflowBlocks() const { return overflow_.size(); }
+    };
+}  // namespace http
+}  // namespace Lute
@@ -0,0 +1,49 @@
+/**
+ * @file StatementCache.h
+ * @brief Server-side prepared statements, per MySQL connection.
+ *
+ * @author Lux
+ */
+
+#pragma once
+
+#include <LuteBase.h>
+#include <mysql/mysql.h>
+
+#include <string>
+#include <unordered_map>
+
+namespace Lute {
+namespace http {
+
+    /// Prepares a statement once per pooled connection and hands it out on
+    /// later uses of that connection, so the server parses the SQL only once.
+    ///
+    /// A connection is used by one thread at a time, so the returned
+    /// statement needs no lock. Thread safe.
+    class StatementCache {
+    private:
+        using Statements = std::unordered_map<std::string, MYSQL_STMT*>;
+
+        MutexLock mutex_;
+        std::unordered_map<MYSQL*, Statements> connections_ GUARDED_BY(mutex_);
+
+    public:
+        StatementCache(const StatementCache&) = delete;
+        StatementCache& operator=(const StatementCache&) = delete;
+
+        StatementCache() = default;
+        ~StatementCache();
+
+        /// @c sql prepared on @c mysql, nullptr on error.
+        MYSQL_STMT* get(MYSQL* mysql, const std::string& sql);
+
+        /// Closes the statements of @c mysql, e.g. after a reconnect, which
+        /// drops them on the server.
+        void invalidate(MYSQL* mysql);
+
+        /// Errors after which the statements of a connection are gone.
+        static bool isConnectionLost(unsigned int error);
+    };
+}  // namespace http
+}  // namespace Lute
@@ -0,0 +1,91 @@
+/**
+ * @file UserInserter.h
+ * @brief Write-behind batching of user INSERTs.
+ *
+ * @author Lux
+ */
+
+#pragma once
+
+#include <LuteBase.h>
+#include <LutePolaris.h>
+#include <http/AsyncMySQLPool.h>
+#include <http/StatementCache.h>
+#include <polaris/EventLoopThread.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Lute {
+namespace http {
+
+    /// Coalesces concurrent registrations into one multi-row INSERT.
+    ///
+    /// The first row of a batch waits kWindow seconds for others to join, up
+    /// to kMaxBatch rows, then the batch acquires a connection from the pool
+    /// and runs as a prepared statement. If it fails, e.g. one duplicate
+    /// user, every row is retried alone so each caller learns its own result.
+    /// Callbacks run in the inserter thread.
+    class UserInserter {
+    public:
+        using Callback = std::function<void(bool ok)>;
+
+        static const size_t kMaxBatch = 64;
+        static constexpr double kWindow = 0.005;
+
+    private:
+        struct Row {
+            std::string username;
+            std::string mail;
+            std::string passwd;
+            Callback cb;
+        };
+
+        using Rows = std::vector<Row>;
+        using RowsPtr = std::shared_ptr<Rows>;
+
+        AsyncMySQLPool* pool_;
+        StatementCache statements_;
+
+        EventLoopThread thread_;
+        EventLoop* loop_;
+
+        // in loop_
+        Rows queue_;
+        bool flushQueued_;
+        // batches waiting for or holding a connection
+        int inFlight_;
+        // set by the destructor
+        CountDownLatch* drained_;
+
+        /// In loop_
+        void enqueue(Row& row);
+        void flushQueue();
+        void flush(const RowsPtr& rows, const AsyncMySQLPool::LeasePtr& lease);
+        void finishBatch();
+        /// INSERTs rows [begin, begin + n) in one statement
+        bool execute(AsyncMySQLPool::Lease& lease, const Rows& rows,
+                     size_t begin, size_t n);
+
+        static std::string insertSql(size_t n);
+
+    public:
+        UserInserter(const UserInserter&) = delete;
+        UserInserter& operator=(const UserInserter&) = delete;
+
+        /// Closes statements prepared on the pool's connections.
+        explicit UserInserter(AsyncMySQLPool* pool);
+        /// Flushes what is queued, then stops. The pool may be destroyed
+        /// after it.
+        ~UserInserter();
+
+        void start();
+
+        /// Thread safe, @c cb is called once with the result.
+        void insert(const std::string& username, const std::string& mail,
+                    const std::string& passwd, Callback cb);
+    };
+}  // namespace http
+}  // namespace Lute
@@ -0,0 +1,90 @@
+/**
+ * @file UserWarmer.h
+ * @brief Loads the user table into Redis and the credential cache.
+ *
+ * @author Lux
+ */
+
+#pragma once
+
+#include <LuteBase.h>
+#include <LuteMySQL.h>
+#include <LutePolaris.h>
+#include <http/AsyncRedisClient.h>
+#include <polaris/EventLoopThread.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Lute {
+namespace http {
+
+    class CredentialCache;
+
+    /// Startup warm-up, run in its own thread so the server accepts
+    /// connections meanwhile.
+    ///
+    /// Users are read from MySQL in keyset-paginated chunks and written to
+    /// Redis as pipelined HMSET batches through an AsyncRedisClient on a
+    /// private loop; the next chunk is read while the previous one is in
+    /// flight. Progress and throughput are logged per chunk. The in-process
+    /// CredentialCache is only filled until it is full.
+    class UserWarmer {
+    public:
+        static const int kChunkSize = 5000;
+        // fields per HMSET
+        static const int kBatchSize = 500;
+        /// Seconds a batch may take to be answered, the warm-up fails once
+        /// a chunk's batches have all taken that long.
+        static constexpr double kBatchTimeout = 5.0;
+
+        using Rows = std::vector<std::pair<std::string, std::string>>;
+
+    private:
+        mysql::MySQLConnPool* connPool_;
+        const InetAddress redisAddr_;
+        const std::string hashKey_;
+        CredentialCache* cache_;
+
+        Thread thread_;
+        EventLoopThread redisThread_;
+        EventLoop* redisLoop_;
+        // lives and dies in redisLoop_
+        std::unique_ptr<AsyncRedisClient> redis_;
+
+        std::atomic<bool> stop_;
+        std::atomic<bool> done_;
+
+        MutexLock mutex_;
+        Condition cond_ GUARDED_BY(mutex_);
+        // HMSET batches not answered yet
+        int inFlight_ GUARDED_BY(mutex_);
+        int64_t numErrors_ GUARDED_BY(mutex_);
+
+        void run();
+        /// Users after @c last in username order, at most kChunkSize.
+        bool loadChunk(const std::string& last, Rows* rows);
+        void sendChunk(const Rows& rows);
+        /// @return false if stopped meanwhile, or Redis did not answer in
+        /// time; the batches not answered count as failed then
+        bool waitForReplies();
+
+    public:
+        UserWarmer(const UserWarmer&) = delete;
+        UserWarmer& operator=(const UserWarmer&) = delete;
+
+        UserWarmer(mysql::MySQLConnPool* connPool,
+                   const InetAddress& redisAddr, const std::string& hashKey,
+                   CredentialCache* cache);
+        /// Stops the warm-up if still running.
+        ~UserWarmer();
+
+        void start();
+        /// True once every user is loaded, or the warm-up failed.
+        bool done() const { return done_.load(); }
+    };
+}  // namespace http
+}  // namespace Lute
@@ -10,33 +10,51 @@
 #include <LuteBase.h>
 #include <LuteMySQL.h>
 #include <LuteRedis.h>
+#include <http/AsyncMySQLPool.h>
+#include <http/AsyncRedisClient.h>
+#include <http/CredentialCache.h>
+#include <http/FileCache.h>
 #include <http/HttpRequest.h>
 #include <http/HttpResponse.h>
 #include <http/HttpServer.h>
+#include <http/Router.h>
+#include <http/ScratchArena.h>
+#include <http/UserInserter.h>
+#include <http/UserWarmer.h>
 #include <mysql/mysql.h>
-#include <sys/stat.h>
 #include <unistd.h>
 
 #include <fstream>
 #include <map>
-#include <regex>
+#include <string_view>
+#include <vector>
 
 namespace Lute {
 namespace http {
 
     class Application {
     public:
-        static const int FILENAME_LEN = 200;
+        // seconds between static file mtime checks
+        static constexpr double kRevalidateInterval = 2.0;
+        // threads running blocking work off the IO loops: deferred handlers
+        // and static file compression
+        static const int kNumWorkers = 4;
+        static const uint16_t kRedisPort = 6379;
+        static const int kRedisTimeoutMs = 1200;
+        // seconds a user, or the lack of one, is trusted without Redis
+        static constexpr double kCredentialTtl = 300.0;
+        static constexpr double kNegativeCredentialTtl = 10.0;
 
     private:
         Lute::EventLoop* loop_;
         HttpServer server_;
+        Router router_;
         int numThreads_;
 
-        char realFile_[FILENAME_LEN];
         std::string serverPath_;
-        struct stat fileStat_;
-        char* fileAddr_;
+        FileCache fileCache_;
+        // destructs before fileCache_, which its tasks refer to
+        ThreadPool workerPool_;
 
         std::string dbIpAddr_;
         uint16_t dbPort_;
@@ -48,9 +66,21 @@ namespace http {
         std::string dbName_;
         // 数据库连接池
         mysql::MySQLConnPool* connPool_;
+        // non-blocking acquire, for the request path
+        AsyncMySQLPool mysqlPool_;
+
+        // consulted before Redis
+        CredentialCache credentials_;
+        // fills Redis and credentials_ at startup
+        UserWarmer warmer_;
+        // batches /register INSERTs, destructs before mysqlPool_ and clears
+        // the close callback it set on it
+        UserInserter inserter_;
+
+        // IO loops with an async Redis client, see ~Application()
+        MutexLock redisLoopsMutex_;
+        std::vector<EventLoop*> redisLoops_ GUARDED_BY(redisLoopsMutex_);
 
-        // Redis
-        redis::RedisConn redisConn_;
 
     public:
         Application(Lute::EventLoop* loop, const Lute::InetAddress& listenAddr,
@@ -58,6 +88,8 @@ namespace http {
                     const std::string& dbIpAddr, uint16_t dbPort,
                     const std::string& dbUser, const std::string& dbPasswd,
                     const std::string& dbName);
+        /// In the loop thread, while the IO loops still run.
+        ~Application();
 
         void onRequest(const HttpRequest& req, HttpResponse* resp);
 
@@ -65,7 +97,37 @@ namespace http {
         void start() { server_.start(); }
 
     private:
-        std::string getHtml();
+        // routes
+        void onIndex(const HttpRequest& req, const Router::Params&,
+                     HttpResponse* resp);
+        void onRegister(const HttpRequest& req, const Router::Params&,
+                        HttpResponse* resp);
+        void onWelcome(const HttpRequest& req, const Router::Params&,
+                       HttpResponse* resp);
+        void onImage(const HttpRequest& req, const Router::Params&,
+                     HttpResponse* resp);
+        void onLogin(const HttpRequest& req, const Router::Params&,
+                     HttpResponse* resp);
+        void onNotFound(const HttpRequest& req, const Router::Params&,
+                        HttpResponse* resp);
+
+        /// Blocking Redis connection of the calling thread, workers connect
+        /// once at start, so no lock is shared between them.
+        static redis::RedisConn& redisConn();
+        /// Async Redis client of the calling IO loop, nullptr elsewhere.
+        static AsyncRedisClient* asyncRedis();
+
+        void setLoginBody(bool ok, const HttpRequest& req, HttpResponse* resp);
+        /// Caches a new user and writes it to Redis from @c loop.
+        void storeCredential(EventLoop* loop, const std::string& username,
+                             const std::string& passwd);
+        /// Serves @c name under serverPath_. Thread safe, for deferred
+        /// handlers too.
+        void setFileBody(std::string_view name, const HttpRequest& req,
+                         HttpResponse* resp);
+        /// Files too big for fileCache_, no ranges nor compression.
+        void setFileStream(const FileCache::FilePtr& file,
+                           const HttpRequest& req, HttpResponse* resp);
     };
 }  // namespace http
 }  // namespace Lute
\ No newline at end of file
@@ -0,0 +1,270 @@
+/**
+ * @file AsyncMySQLPool.cc
+ * @brief
+ *
+ * @author Lux
+ */
+
+#include <http/AsyncMySQLPool.h>
+
+#include <algorithm>
+
+using namespace Lute;
+using namespace Lute::http;
+
+namespace {
+
+const unsigned int kConnectTimeoutSeconds = 3;
+
+}  // namespace
+
+AsyncMySQLPool::Lease::~Lease() {
+    pool_->release(mysql_, broken_,
+                   timeDifference(Timestamp::now(), acquired_));
+}
+
+AsyncMySQLPool::AsyncMySQLPool(const Options& options)
+    : options_(options),
+      thread_(new EventLoopThread(EventLoopThread::ThreadInitCallback(),
+                                  "AsyncMySQLPool")),
+      loop_(nullptr),
+      size_(0),
+      metrics_() {
+    assert(options_.minSize <= options_.maxSize);
+}
+
+AsyncMySQLPool::~AsyncMySQLPool() {
+    // no open() or maintain() after this
+    thread_.reset();
+
+    MutexLockGuard lock(mutex_);
+    for (const Idle& idle : idle_) close(idle.mysql);
+    idle_.clear();
+    if (!waiters_.empty()) {
+        LOG_WARN << "AsyncMySQLPool drops " << waiters_.size() << " waiters";
+    }
+}
+
+void AsyncMySQLPool::setCloseCallback(const CloseCallback& cb) {
+    // close() runs in loop_, or once thread_ is gone
+    if (loop_ == nullptr) {
+        closeCallback_ = cb;
+        return;
+    }
+    CountDownLatch latch(1);
+    loop_->runInLoop([this, &cb, &latch] {
+        closeCallback_ = cb;
+        latch.countDown();
+    });
+    latch.wait();
+}
+
+void AsyncMySQLPool::start() {
+    loop_ = thread_->startLoop();
+    {
+        MutexLockGuard lock(mutex_);
+        size_ = options_.minSize;
+    }
+    loop_->runInLoop([this] {
+        for (int i = 0; i < options_.minSize; ++i) open();
+    });
+    loop_->runEvery(kMaintenanceInterval,
+                    std::bind(&AsyncMySQLPool::maintain, this));
+    loop_->runEvery(kMetricsInterval,
+                    std::bind(&AsyncMySQLPool::logMetrics, this));
+}
+
+void AsyncMySQLPool::acquire(EventLoop* loop, AcquireCallback cb) {
+    const Timestamp now = Timestamp::now();
+    MYSQL* mysql = nullptr;
+    bool grow = false;
+    {
+        MutexLockGuard lock(mutex_);
+        ++metrics_.acquires;
+        // idle ones go to waiters first, in order
+        if (!idle_.empty() && waiters_.empty()) {
+            mysql = idle_.back().mysql;
+            idle_.pop_back();
+        } else {
+            ++metrics_.waits;
+            if (size_ < options_.maxSize) {
+                ++size_;
+                grow = true;
+            } else {
+                ++metrics_.exhaustions;
+            }
+            waiters_.push_back(Waiter{loop, std::move(cb), now});
+        }
+    }
+
+    if (mysql) deliver(Waiter{loop, std::move(cb), now}, mysql);
+    if (grow) loop_->queueInLoop(std::bind(&AsyncMySQLPool::open, this));
+}
+
+void AsyncMySQLPool::deliver(const Waiter& waiter, MYSQL* mysql) {
+    if (mysql) {
+        const double wait = timeDifference(Timestamp::now(), waiter.since);
+        MutexLockGuard lock(mutex_);
+        metrics_.totalWait += wait;
+        metrics_.maxWait = std::max(metrics_.maxWait, wait);
+    }
+
+    LeasePtr lease = mysql ? std::make_shared<Lease>(this, mysql) : nullptr;
+    AcquireCallback cb = waiter.cb;
+    waiter.loop->queueInLoop([cb, lease] { cb(lease); });
+}
+
+void AsyncMySQLPool::release(MYSQL* mysql, bool broken, double held) {
+    bool grow = false;
+    {
+        MutexLockGuard lock(mutex_);
+        metrics_.totalHold += held;
+        metrics_.maxHold = std::max(metrics_.maxHold, held);
+        if (broken) {
+            // a replacement for whoever waits
+            grow = !waiters_.empty();
+            if (!grow) --size_;
+        }
+    }
+
+    if (broken) {
+        loop_->queueInLoop([this, mysql] { close(mysql); });
+        if (grow) loop_->queueInLoop(std::bind(&AsyncMySQLPool::open, this));
+    } else {
+        handOff(mysql);
+    }
+}
+
+void AsyncMySQLPool::handOff(MYSQL* mysql) {
+    Waiter waiter;
+    {
+        MutexLockGuard lock(mutex_);
+        if (waiters_.empty()) {
+            idle_.push_back(Idle{mysql, Timestamp::now()});
+            return;
+        }
+        waiter = std::move(waiters_.front());
+        waiters_.pop_front();
+    }
+    deliver(waiter, mysql);
+}
+
+void AsyncMySQLPool::close(MYSQL* mysql) {
+    if (closeCallback_) closeCallback_(mysql);
+    ::mysql_close(mysql);
+}
+
+void AsyncMySQLPool::open() {
+    loop_->assertInLoopThread();
+    MYSQL* mysql = ::mysql_init(nullptr);
+    if (mysql) {
+        ::mysql_options(mysql, MYSQL_SET_CHARSET_NAME,
+                        options_.charset.c_str());
+        ::mysql_options(mysql, MYSQL_OPT_CONNECT_TIMEOUT,
+                        &kConnectTimeoutSeconds);
+    }
+
+    if (mysql == nullptr ||
+        ::mysql_real_connect(mysql, options_.host.c_str(),
+                             options_.user.c_str(), options_.passwd.c_str(),
+                             options_.db.c_str(), options_.port, nullptr,
+                             0) == nullptr) {
+        LOG_ERROR << "AsyncMySQLPool connect to " << options_.host << ":"
+                  << options_.port << " failed: "
+                  << (mysql ? ::mysql_error(mysql) : "mysql_init");
+        if (mysql) ::mysql_close(mysql);
+
+        std::deque<Waiter> failed;
+        {
+            MutexLockGuard lock(mutex_);
+            --size_;
+            ++metrics_.connectFailures;
+            // nothing will ever be released to them
+            if (size_ == 0) failed.swap(waiters_);
+        }
+        for (const Waiter& waiter : failed) deliver(waiter, nullptr);
+        return;
+    }
+
+    handOff(mysql);
+}
+
+void AsyncMySQLPool::maintain() {
+    const Timestamp now = Timestamp::now();
+    std::vector<Waiter> expired;
+    std::vector<MYSQL*> reaped;
+    std::vector<MYSQL*> unchecked;
+    int missing = 0;
+    {
+        MutexLockGuard lock(mutex_);
+        // all waiters have the same timeout, the oldest are in front
+        while (!waiters_.empty() &&
+               timeDifference(now, waiters_.front().since) >
+                   options_.acquireTimeout) {
+            expired.push_back(std::move(waiters_.front()));
+            waiters_.pop_front();
+            ++metrics_.timeouts;
+        }
+
+        // least recently used in front
+        while (size_ > options_.minSize && !idle_.empty() &&
+               timeDifference(now, idle_.front().lastUsed) >
+                   options_.idleTimeout) {
+            reaped.push_back(idle_.front().mysql);
+            idle_.pop_front();
+            --size_;
+        }
+
+        // out of the idle list while pinged, so nobody gets them meanwhile
+        for (auto it = idle_.begin(); it != idle_.end();) {
+            if (timeDifference(now, it->lastUsed) >
+                options_.healthCheckInterval) {
+                unchecked.push_back(it->mysql);
+                it = idle_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        missing = std::max(0, options_.minSize - size_);
+        size_ += missing;
+    }
+
+    for (const Waiter& waiter : expired) deliver(waiter, nullptr);
+    for (MYSQL* mysql : reaped) close(mysql);
+
+    for (MYSQL* mysql : unchecked) {
+        if (::mysql_ping(mysql) == 0) {
+            handOff(mysql);
+        } else {
+            LOG_WARN << "AsyncMySQLPool ping failed: " << ::mysql_error(mysql);
+            close(mysql);
+            // reopened right away to keep waiters going
+            open();
+        }
+    }
+
+    for (int i = 0; i < missing; ++i) open();
+}
+
+void AsyncMySQLPool::logMetrics() {
+    Metrics m = metrics();
+    LOG_INFO << "AsyncMySQLPool size " << m.size << " idle " << m.idle
+             << " waiting " << m.waiting << " acquires " << m.acquires
+             << " waits " << m.waits << " exhaustions " << m.exhaustions
+             << " timeouts " << m.timeouts << " avg wait "
+             << (m.waits ? m.totalWait / static_cast<double>(m.waits) : 0)
+             << "s max wait " << m.maxWait << "s avg hold "
+             << (m.acquires ? m.totalHold / static_cast<double>(m.acquires)
+                            : 0)
+             << "s max hold " << m.maxHold << "s";
+}
+
+AsyncMySQLPool::Metrics AsyncMySQLPool::metrics() const {
+    MutexLockGuard lock(mutex_);
+    Metrics m = metrics_;
+    m.size = size_;
+    m.idle = static_cast<int>(idle_.size());
+    m.waiting = static_cast<int>(waiters_.size());
+    return m;
+}
@@ -0,0 +1,227 @@
+/**
+ * @file AsyncRedisClient.cc
+ * @brief
+ *
+ * @author Lux
+ */
+
+#include <http/AsyncRedisClient.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Lute;
+using namespace Lute::http;
+
+namespace {
+
+const char kCRLF[] = "\r\n";
+
+/// Finds the CRLF ending the line that starts at @c begin
+const char* findLineEnd(const char* begin, const char* end) {
+    const char* crlf = std::search(begin, end, kCRLF, kCRLF + 2);
+    return crlf == end ? nullptr : crlf;
+}
+
+bool parseInteger(const char* begin, const char* end, int64_t* value) {
+    if (begin == end) return false;
+    bool negative = *begin == '-';
+    if (negative) ++begin;
+    if (begin == end) return false;
+
+    int64_t n = 0;
+    for (const char* p = begin; p < end; ++p) {
+        if (*p < '0' || *p > '9') return false;
+        n = n * 10 + (*p - '0');
+    }
+    *value = negative ? -n : n;
+    return true;
+}
+
+}  // namespace
+
+AsyncRedisClient::AsyncRedisClient(EventLoop* loop,
+                                   const InetAddress& serverAddr,
+                                   const std::string& name)
+    : loop_(loop),
+      client_(loop, serverAddr, name),
+      flushQueued_(false),
+      numSent_(0) {
+    client_.setConnectionCallback(std::bind(&AsyncRedisClient::onConnection,
+                                            this, std::placeholders::_1));
+    client_.setMessageCallback(
+        std::bind(&AsyncRedisClient::onMessage, this, std::placeholders::_1,
+                  std::placeholders::_2, std::placeholders::_3));
+    client_.enableRetry();
+}
+
+AsyncRedisClient::~AsyncRedisClient() { failAll("client destroyed"); }
+
+void AsyncRedisClient::connect() { client_.connect(); }
+
+void AsyncRedisClient::disconnect() { client_.disconnect(); }
+
+void AsyncRedisClient::onConnection(const TCPConnectionPtr& conn) {
+    LOG_INFO << "AsyncRedisClient " << conn->peerAddress().toIpPort() << " is "
+             << (conn->connected() ? "up" : "down");
+
+    if (conn->connected()) {
+        conn->setTcpNoDelay(true);
+        conn_ = conn;
+        // commands issued while connecting
+        flush();
+    } else {
+        conn_.reset();
+        // replies to what was sent are lost, the rest is sent on reconnect
+        Reply error;
+        error.type = Reply::kError;
+        error.str = "ERR connection lost";
+        for (; numSent_ > 0; --numSent_) {
+            ReplyCallback cb = std::move(callbacks_.front());
+            callbacks_.pop_front();
+            if (cb) cb(error);
+        }
+    }
+
+    if (connectCallback_) connectCallback_(conn->connected());
+}
+
+void AsyncRedisClient::onMessage(const TCPConnectionPtr&, Buffer* buf,
+                                 Timestamp) {
+    while (buf->readableBytes() > 0) {
+        Reply reply;
+        const char* next = nullptr;
+        ParseResult result = parseReply(
+            buf->peek(), buf->peek() + buf->readableBytes(), &reply, &next);
+        if (result == ParseResult::kIncomplete) break;
+
+        if (result == ParseResult::kError || numSent_ == 0) {
+            LOG_ERROR << "AsyncRedisClient bad reply, reconnecting";
+            buf->retrieveAll();
+            if (conn_) conn_->forceClose();
+            break;
+        }
+
+        buf->retrieveUntil(next);
+        --numSent_;
+        ReplyCallback cb = std::move(callbacks_.front());
+        callbacks_.pop_front();
+        if (cb) cb(reply);
+    }
+}
+
+void AsyncRedisClient::command(const std::vector<std::string>& args,
+                               ReplyCallback cb) {
+    loop_->assertInLoopThread();
+    encode(args, &pending_);
+    callbacks_.push_back(std::move(cb));
+
+    // one write for all commands of this loop iteration
+    if (!flushQueued_ && connected()) {
+        flushQueued_ = true;
+        loop_->queueInLoop(std::bind(&AsyncRedisClient::flush, this));
+    }
+}
+
+void AsyncRedisClient::flush() {
+    flushQueued_ = false;
+    if (connected() && pending_.readableBytes() > 0) {
+        conn_->send(&pending_);
+        numSent_ = callbacks_.size();
+    }
+}
+
+void AsyncRedisClient::failAll(const std::string& reason) {
+    Reply error;
+    error.type = Reply::kError;
+    error.str = "ERR " + reason;
+    pending_.retrieveAll();
+    numSent_ = 0;
+    std::deque<ReplyCallback> callbacks;
+    callbacks.swap(callbacks_);
+    for (const ReplyCallback& cb : callbacks) {
+        if (cb) cb(error);
+    }
+}
+
+void AsyncRedisClient::encode(const std::vector<std::string>& args,
+                              Buffer* buf) {
+    char header[32];
+    int n = ::snprintf(header, sizeof(header), "*%zu\r\n", args.size());
+    buf->append(header, static_cast<size_t>(n));
+    for (const std::string& arg : args) {
+        n = ::snprintf(header, sizeof(header), "$%zu\r\n", arg.size());
+        buf->append(header, static_cast<size_t>(n));
+        buf->append(arg);
+        buf->append(kCRLF, 2);
+    }
+}
+
+AsyncRedisClient::ParseResult AsyncRedisClient::parseReply(
+    const char* begin, const char* end, Reply* reply, const char** next) {
+    if (begin == end) return ParseResult::kIncomplete;
+    const char* crlf = findLineEnd(begin + 1, end);
+    if (crlf == nullptr) return ParseResult::kIncomplete;
+
+    const char* line = begin + 1;
+    int64_t n = 0;
+    switch (*begin) {
+        case '+':
+        case '-':
+            reply->type = *begin == '+' ? Reply::kStatus : Reply::kError;
+            reply->str.assign(line, crlf);
+            *next = crlf + 2;
+            return ParseResult::kOk;
+
+        case ':':
+            if (!parseInteger(line, crlf, &n)) return ParseResult::kError;
+            reply->type = Reply::kInteger;
+            reply->integer = n;
+            *next = crlf + 2;
+            return ParseResult::kOk;
+
+        case '$': {
+            if (!parseInteger(line, crlf, &n)) return ParseResult::kError;
+            if (n < 0) {
+                reply->type = Reply::kNil;
+                *next = crlf + 2;
+                return ParseResult::kOk;
+            }
+            const char* data = crlf + 2;
+            const size_t len = static_cast<size_t>(n);
+            if (static_cast<size_t>(end - data) < len + 2)
+                return ParseResult::kIncomplete;
+            if (data[len] != '\r' || data[len + 1] != '\n')
+                return ParseResult::kError;
+            reply->type = Reply::kString;
+            reply->str.assign(data, len);
+            *next = data + len + 2;
+            return ParseResult::kOk;
+        }
+
+        case '*': {
+            if (!parseInteger(line, crlf, &n)) return ParseResult::kError;
+            if (n < 0) {
+                reply->type = Reply::kNil;
+                *next = crlf + 2;
+                return ParseResult::kOk;
+            }
+            const char* p = crlf + 2;
+            // every element takes 3 bytes at least, do not trust n blindly
+            if (n > (end - p) / 3) return ParseResult::kIncomplete;
+            reply->type = Reply::kArray;
+            reply->elements.resize(static_cast<size_t>(n));
+            for (Reply& element : reply->elements) {
+                ParseResult result = parseReply(p, end, &element, &p);
+                if (result != ParseResult::kOk) return result;
+            }
+            *next = p;
+            return ParseResult::kOk;
+        }
+
+        default:
+            return ParseResult::kError;
+    }
+}
@@ -0,0 +1,109 @@
+/**
+ * @file CredentialCache.cc
+ * @brief
+ *
+ * @author Lux
+ */
+
+#include <http/CredentialCache.h>
+
+using namespace Lute;
+using namespace Lute::http;
+
+const int CredentialCache::kNumShards;
+const size_t CredentialCache::kDefaultMaxEntriesPerShard;
+
+CredentialCache::CredentialCache(double ttl, double negativeTtl,
+                                 size_t maxEntriesPerShard)
+    : ttl_(ttl),
+      negativeTtl_(negativeTtl),
+      maxEntriesPerShard_(maxEntriesPerShard),
+      clock_(&Timestamp::now) {
+    assert(maxEntriesPerShard_ > 0);
+}
+
+CredentialCache::Lookup CredentialCache::find(const std::string& username,
+                                              std::string* passwd) {
+    Shard& shard = shardOf(username);
+    MutexLockGuard lock(shard.mutex);
+    auto it = shard.entries.find(username);
+    if (it == shard.entries.end()) return Lookup::kMiss;
+
+    const Slot slot = it->second;
+    if (slot.pos->expiration < clock_()) {
+        shard.entries.erase(it);
+        shard.listOf(slot.exists).erase(slot.pos);
+        return Lookup::kMiss;
+    }
+    if (!slot.exists) return Lookup::kAbsent;
+
+    *passwd = slot.pos->passwd;
+    return Lookup::kFound;
+}
+
+bool CredentialCache::insert(const std::string& username,
+                             const std::string& passwd, bool exists,
+                             double ttl, bool evict) {
+    const Timestamp now = clock_();
+    Shard& shard = shardOf(username);
+    MutexLockGuard lock(shard.mutex);
+    ExpiryList& list = shard.listOf(exists);
+
+    auto it = shard.entries.find(username);
+    if (it != shard.entries.end()) {
+        // to the front of its list, the key stays where it is
+        Slot& slot = it->second;
+        list.splice(list.begin(), shard.listOf(slot.exists), slot.pos);
+        slot.exists = exists;
+    } else {
+        if (!makeRoom(shard, now, maxEntriesPerShard_, evict)) return false;
+        list.push_front(Entry{username, std::string(), Timestamp()});
+        shard.entries[list.front().username] = Slot{list.begin(), exists};
+    }
+
+    Entry& entry = list.front();
+    entry.passwd = passwd;
+    entry.expiration = addTime(now, ttl);
+    return true;
+}
+
+bool CredentialCache::makeRoom(Shard& shard, Timestamp now, size_t max,
+                               bool evict) {
+    if (shard.entries.size() < max) return true;
+
+    // what has expired is at the back, each entry is dropped once
+    for (ExpiryList* list : {&shard.absent, &shard.known}) {
+        while (!list->empty() && list->back().expiration < now) {
+            shard.entries.erase(list->back().username);
+            list->pop_back();
+        }
+    }
+    if (shard.entries.size() < max) return true;
+    if (!evict) return false;
+
+    // unknown users are the cheaper to look up again
+    ExpiryList& victims = shard.absent.empty() ? shard.known : shard.absent;
+    shard.entries.erase(victims.back().username);
+    victims.pop_back();
+    return true;
+}
+
+void CredentialCache::erase(const std::string& username) {
+    Shard& shard = shardOf(username);
+    MutexLockGuard lock(shard.mutex);
+    auto it = shard.entries.find(username);
+    if (it == shard.entries.end()) return;
+
+    const Slot slot = it->second;
+    shard.entries.erase(it);
+    shard.listOf(slot.exists).erase(slot.pos);
+}
+
+size_t CredentialCache::size() {
+    size_t n = 0;
+    for (Shard& shard : shards_) {
+        MutexLockGuard lock(shard.mutex);
+        n += shard.entries.size();
+    }
+    return n;
+}
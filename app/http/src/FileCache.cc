@@ -0,0 +1,397 @@
+/**
+ * @file FileCache.cc
+ * @brief
+ *
+ * @author Lux
+ */
+
+#include <LutePolaris.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <http/FileCache.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef LUTE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+using namespace Lute;
+using namespace Lute::http;
+
+namespace {
+
+/// RFC 7231 IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+std::string formatHttpDate(time_t t) {
+    struct tm tm;
+    ::gmtime_r(&t, &tm);
+    char buf[64];
+    size_t n = ::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return std::string(buf, n);
+}
+
+#ifdef LUTE_HAVE_ZLIB
+/// q of "q=0.5", [begin, end) needs no terminating NUL.
+double parseQValue(const char* begin, const char* end) {
+    char buf[16];
+    size_t len = std::min(static_cast<size_t>(end - begin), sizeof(buf) - 1);
+    ::memcpy(buf, begin, len);
+    buf[len] = '\0';
+    return ::strtod(buf, nullptr);
+}
+#endif
+
+bool readAll(int fd, std::string* content, size_t size) {
+    content->resize(size);
+    size_t nread = 0;
+    while (nread < size) {
+        ssize_t n = ::read(fd, &(*content)[nread], size - nread);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        } else if (n == 0) {
+            // truncated while reading
+            content->resize(nread);
+            break;
+        }
+        nread += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// smaller bodies do not pay for the extra headers
+const size_t kMinCompressSize = 256;
+
+bool isCompressible(const std::string& contentType) {
+    return contentType.compare(0, 5, "text/") == 0 ||
+           contentType == "application/javascript" ||
+           contentType == "application/json" || contentType == "image/svg+xml";
+}
+
+#ifdef LUTE_HAVE_ZLIB
+/// @param windowBits 15 + 16 for gzip, 15 for zlib wrapped deflate
+std::shared_ptr<const std::string> deflateString(const std::string& in,
+                                                 int windowBits) {
+    z_stream zs;
+    memZero(&zs, sizeof(zs));
+    if (::deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, windowBits, 8,
+                       Z_DEFAULT_STRATEGY) != Z_OK) {
+        return nullptr;
+    }
+
+    auto out = std::make_shared<std::string>();
+    out->resize(::deflateBound(&zs, static_cast<uLong>(in.size())));
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&(*out)[0]);
+    zs.avail_out = static_cast<uInt>(out->size());
+
+    int ret = ::deflate(&zs, Z_FINISH);
+    out->resize(zs.total_out);
+    ::deflateEnd(&zs);
+    return ret == Z_STREAM_END ? out : nullptr;
+}
+#endif
+
+size_t footprint(const FileCache::FilePtr& file) {
+    size_t n = file->content.size();
+    auto gzip = std::atomic_load(&file->gzip);
+    auto deflate = std::atomic_load(&file->deflate);
+    if (gzip) n += gzip->size();
+    if (deflate) n += deflate->size();
+    return n;
+}
+
+}  // namespace
+
+const size_t FileCache::kDefaultCapacity;
+
+FileCache::FileCache(size_t capacity)
+    : capacity_(capacity), compressPool_(nullptr), bytes_(0) {}
+
+FileCache::FilePtr FileCache::get(std::string_view path) {
+    {
+        MutexLockGuard lock(mutex_);
+        auto it = entries_.find(path);
+        if (it != entries_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second.pos);
+            return it->second.file;
+        }
+    }
+
+    // load outside the lock, IO threads only contend on the map
+    FilePtr file = load(std::string(path), capacity_ / 8);
+    if (file && !file->streamed) {
+        insert(file);
+        compressAsync(file);
+    }
+    return file;
+}
+
+void FileCache::preload(const std::string& dir) {
+    DIR* dp = ::opendir(dir.c_str());
+    if (dp == nullptr) {
+        LOG_SYSERR << "FileCache::preload " << dir;
+        return;
+    }
+
+    while (struct dirent* ent = ::readdir(dp)) {
+        if (ent->d_name[0] == '.') continue;
+        // get() skips directories
+        get(dir + "/" + ent->d_name);
+    }
+    ::closedir(dp);
+    LOG_INFO << "FileCache preloads " << size() << " files from " << dir;
+}
+
+std::shared_ptr<const std::string> FileCache::body(const FilePtr& file,
+                                                   int accepted,
+                                                   Encoding* encoding) {
+    if (file->compressible) {
+        if (accepted & kGzip) {
+            auto gzip = std::atomic_load(&file->gzip);
+            if (gzip) {
+                *encoding = kGzip;
+                return gzip;
+            }
+        }
+        if (accepted & kDeflate) {
+            auto deflate = std::atomic_load(&file->deflate);
+            if (deflate) {
+                *encoding = kDeflate;
+                return deflate;
+            }
+        }
+        // not ready yet, make sure it is on the way
+        if (accepted != kIdentity) compressAsync(file);
+    }
+
+    *encoding = kIdentity;
+    // share ownership with the cache entry, no copy
+    return std::shared_ptr<const std::string>(file, &file->content);
+}
+
+void FileCache::compressAsync(const FilePtr& file) {
+    if (!compressPool_ || !file->compressible) return;
+    // uncached files would be compressed again on every request
+    if (file->content.size() > capacity_ / 8) return;
+    if (file->compressing.exchange(true)) return;
+
+    // FileCache outlives the pool, which is stopped by the owner first
+    compressPool_->run([this, file] {
+        std::shared_ptr<const std::string> gzip, deflate;
+        compress(*file, &gzip, &deflate);
+
+        // published and charged together, or evictIfNeeded() and
+        // revalidate() could take off bytes that were never added
+        MutexLockGuard lock(mutex_);
+        std::atomic_store(&file->gzip, gzip);
+        std::atomic_store(&file->deflate, deflate);
+        auto it = entries_.find(file->path);
+        if (it != entries_.end() && it->second.file == file) {
+            bytes_ += footprint(file) - file->content.size();
+            evictIfNeeded();
+        }
+    });
+}
+
+void FileCache::compress(const File& file,
+                         std::shared_ptr<const std::string>* gzip,
+                         std::shared_ptr<const std::string>* deflate) {
+#ifdef LUTE_HAVE_ZLIB
+    *gzip = deflateString(file.content, 15 + 16);
+    *deflate = deflateString(file.content, 15);
+    LOG_DEBUG << "FileCache compresses " << file.path << " "
+              << file.content.size() << " bytes";
+#else
+    (void)file;
+    (void)gzip;
+    (void)deflate;
+#endif
+}
+
+void FileCache::insert(const FilePtr& file) {
+    // too big to share the cache with others, serve uncached
+    if (file->content.size() > capacity_ / 8) return;
+
+    MutexLockGuard lock(mutex_);
+    if (entries_.find(file->path) != entries_.end()) return;
+
+    lru_.push_front(file);
+    entries_[file->path] = Entry{file, lru_.begin()};
+    bytes_ += footprint(file);
+    evictIfNeeded();
+}
+
+void FileCache::evictIfNeeded() {
+    while (bytes_ > capacity_ && !lru_.empty()) {
+        const FilePtr& victim = lru_.back();
+        LOG_DEBUG << "FileCache evicts " << victim->path;
+        bytes_ -= footprint(victim);
+        entries_.erase(victim->path);
+        lru_.pop_back();
+    }
+}
+
+void FileCache::revalidate() {
+    std::vector<FilePtr> files;
+    {
+        MutexLockGuard lock(mutex_);
+        files.assign(lru_.begin(), lru_.end());
+    }
+
+    // stat outside the lock
+    std::vector<FilePtr> stale;
+    for (const FilePtr& file : files) {
+        struct stat st;
+        if (::stat(file->path.c_str(), &st) < 0 ||
+            st.st_mtime != file->mtime || st.st_size != file->size) {
+            stale.push_back(file);
+        }
+    }
+
+    if (stale.empty()) return;
+
+    MutexLockGuard lock(mutex_);
+    for (const FilePtr& file : stale) {
+        auto it = entries_.find(file->path);
+        // may have been evicted or reloaded meanwhile
+        if (it != entries_.end() && it->second.file == file) {
+            LOG_INFO << "FileCache invalidates " << file->path;
+            bytes_ -= footprint(file);
+            lru_.erase(it->second.pos);
+            entries_.erase(it);
+        }
+    }
+}
+
+void FileCache::startRevalidate(EventLoop* loop, double interval) {
+    loop->runEvery(interval, std::bind(&FileCache::revalidate, this));
+}
+
+size_t FileCache::bytes() const {
+    MutexLockGuard lock(mutex_);
+    return bytes_;
+}
+
+size_t FileCache::size() const {
+    MutexLockGuard lock(mutex_);
+    return entries_.size();
+}
+
+FileCache::FilePtr FileCache::load(const std::string& path,
+                                   size_t maxContentSize) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    // NO resource
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    // FORBIDDEN REQUEST / BAD_REQUEST
+    if (::fstat(fd, &st) < 0 || !(st.st_mode & S_IROTH) ||
+        S_ISDIR(st.st_mode)) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto file = std::make_shared<File>();
+    file->path = path;
+    file->mtime = st.st_mtime;
+    file->size = st.st_size;
+    file->contentType = mimeType(path);
+    file->lastModified = formatHttpDate(st.st_mtime);
+    char etag[64];
+    ::snprintf(etag, sizeof(etag), "\"%lx-%lx\"",
+               static_cast<unsigned long>(st.st_mtime),
+               static_cast<unsigned long>(st.st_size));
+    file->etag = etag;
+    file->streamed = static_cast<size_t>(st.st_size) > maxContentSize;
+    file->compressible = !file->streamed &&
+                         isCompressible(file->contentType) &&
+                         static_cast<size_t>(st.st_size) >= kMinCompressSize;
+
+    bool ok = file->streamed ||
+              readAll(fd, &file->content, static_cast<size_t>(st.st_size));
+    ::close(fd);
+    if (!ok) {
+        LOG_SYSERR << "FileCache::load " << path;
+        return nullptr;
+    }
+    return file;
+}
+
+const char* FileCache::mimeType(const std::string& path) {
+    static const struct {
+        const char* ext;
+        const char* type;
+    } kMimeTypes[] = {
+        {".html", "text/html"},  {".htm", "text/html"},
+        {".css", "text/css"},    {".js", "application/javascript"},
+        {".json", "application/json"},
+        {".jpg", "image/jpg"},   {".jpeg", "image/jpeg"},
+        {".png", "image/png"},   {".gif", "image/gif"},
+        {".ico", "image/x-icon"}, {".svg", "image/svg+xml"},
+        {".txt", "text/plain"},
+    };
+
+    size_t dot = path.rfind('.');
+    if (dot != std::string::npos) {
+        const char* ext = path.c_str() + dot;
+        for (const auto& mime : kMimeTypes) {
+            if (::strcasecmp(ext, mime.ext) == 0) return mime.type;
+        }
+    }
+    return "application/octet-stream";
+}
+
+int FileCache::acceptedEncodings(std::string_view acceptEncoding) {
+    int accepted = kIdentity;
+#ifdef LUTE_HAVE_ZLIB
+    // e.g. "gzip, deflate;q=0.5, br;q=0"
+    const char* p = acceptEncoding.data();
+    const char* const end = p + acceptEncoding.size();
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == ',')) ++p;
+        const char* token = p;
+        while (p < end && *p != ',' && *p != ';' && *p != ' ') ++p;
+        size_t len = static_cast<size_t>(p - token);
+
+        double q = 1.0;
+        while (p < end && *p != ',') {
+            if (*p == 'q' && end - p > 1 && *(p + 1) == '=') {
+                q = parseQValue(p + 2, end);
+            }
+            ++p;
+        }
+        if (len == 0 || q <= 0.0) continue;
+
+        if (len == 4 && ::strncasecmp(token, "gzip", 4) == 0) {
+            accepted |= kGzip;
+        } else if (len == 7 && ::strncasecmp(token, "deflate", 7) == 0) {
+            accepted |= kDeflate;
+        } else if (len == 1 && *token == '*') {
+            accepted |= kGzip | kDeflate;
+        }
+    }
+#else
+    (void)acceptEncoding;
+#endif
+    return accepted;
+}
+
+const char* FileCache::encodingName(Encoding encoding) {
+    switch (encoding) {
+        case kGzip:
+            return "gzip";
+        case kDeflate:
+            return "deflate";
+        default:
+            return "identity";
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ * @file FormParams.cc
+ * @brief
+ *
+ * @author Lux
+ */
+
+#include <http/FormParams.h>
+
+#include <algorithm>
+
+using namespace Lute;
+using namespace Lute::http;
+
+namespace {
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+}  // namespace
+
+const int FormParams::kMaxFields;
+
+size_t FormParams::decode(char* begin, char* end) {
+    char* out = begin;
+    for (char* in = begin; in < end; ++in) {
+        if (*in == '+') {
+            *out++ = ' ';
+        } else if (*in == '%' && end - in >= 3) {
+            int hi = hexValue(in[1]);
+            int lo = hexValue(in[2]);
+            if (hi < 0 || lo < 0) {
+                *out++ = *in;
+            } else {
+                *out++ = static_cast<char>(hi << 4 | lo);
+                in += 2;
+            }
+        } else {
+            *out++ = *in;
+        }
+    }
+    return static_cast<size_t>(out - begin);
+}
+
+bool FormParams::parse(const char* begin, const char* end) {
+    clear();
+    if (begin < end && *begin == '?') ++begin;
+
+    // decoding only shrinks, so every field fits in the copy
+    data_.assign(begin, end);
+    char* const base = &data_[0];
+    char* p = base;
+    char* const last = base + data_.size();
+
+    while (p < last) {
+        char* amp = std::find(p, last, '&');
+        if (amp == p) {
+            ++p;
+            continue;
+        }
+        if (size_ == kMaxFields) return false;
+
+        char* eq = std::find(p, amp, '=');
+        Field& f = fields_[static_cast<size_t>(size_)];
+        f.key = static_cast<uint32_t>(p - base);
+        f.keyLen = static_cast<uint32_t>(decode(p, eq));
+        if (eq != amp) {
+            f.value = static_cast<uint32_t>(eq + 1 - base);
+            f.valueLen = static_cast<uint32_t>(decode(eq + 1, amp));
+        } else {
+            f.value = static_cast<uint32_t>(eq - base);
+            f.valueLen = 0;
+        }
+        ++size_;
+        p = amp + 1;
+    }
+    return true;
+}
+
+std::string_view FormParams::get(std::string_view key) const {
+    for (int i = 0; i < size_; ++i) {
+        if (this->key(i) == key) return value(i);
+    }
+    return std::string_view();
+}
+
+bool FormParams::has(std::string_view key) const {
+    for (int i = 0; i < size_; ++i) {
+        if (this->key(i) == key) return true;
+    }
+    return false;
+}
@@ -7,6 +7,9 @@
 
 #include <http/HttpContext.h>
 
+#include <cctype>
+#include <cstdint>
+
 using namespace Lute;
 
 // HTTP/1.1
@@ -24,24 +27,24 @@ bool http::HttpContext::processRequestLine(const char* begin, const char* end) {
     bool succeed = false;
     const char* start = begin;
     const char* space = std::find(start, end, ' ');
-    if (space != end && request_.setMethod(start, space)) {
+    if (space != end && request_->setMethod(start, space)) {
         start = space + 1;
         space = std::find(start, end, ' ');
         if (space != end) {
             const char* question = std::find(start, space, '?');
             if (question != space) {
-                request_.setPath(start, question);
-                request_.setQuery(question, space);
+                request_->setPath(start, question);
+                request_->setQuery(question, space);
             } else {
-                request_.setPath(start, space);
+                request_->setPath(start, space);
             }
             start = space + 1;
             succeed = end - start == 8 && std::equal(start, end - 1, "HTTP/1.");
             if (succeed) {
                 if (*(end - 1) == '1') {
-                    request_.setVersion(HttpRequest::Version::kHttp11);
+                    request_->setVersion(HttpRequest::Version::kHttp11);
                 } else if (*(end - 1) == '0') {
-                    request_.setVersion(HttpRequest::Version::kHttp10);
+                    request_->setVersion(HttpRequest::Version::kHttp10);
                 } else {
                     succeed = false;
                 }
@@ -51,6 +54,23 @@ bool http::HttpContext::processRequestLine(const char* begin, const char* end) {
     return succeed;
 }
 
+namespace {
+
+/// Digits only, false on anything else or on overflow. Empty is 0.
+bool parseContentLength(std::string_view str, size_t* len) {
+    size_t n = 0;
+    for (char c : str) {
+        if (!isdigit(static_cast<unsigned char>(c))) return false;
+        const size_t digit = static_cast<size_t>(c - '0');
+        if (n > (SIZE_MAX - digit) / 10) return false;
+        n = n * 10 + digit;
+    }
+    *len = n;
+    return true;
+}
+
+}  // namespace
+
 // return false if any error
 bool http::HttpContext::parseRequest(Buffer* buf,
                                      Timestamp receiveTime) {
@@ -62,7 +82,7 @@ bool http::HttpContext::parseRequest(Buffer* buf,
             if (crlf) {
                 ok = processRequestLine(buf->peek(), crlf);
                 if (ok) {
-                    request_.setReceiveTime(receiveTime);
+                    request_->setReceiveTime(receiveTime);
                     buf->retrieveUntil(crlf + 2);
                     state_ = HttpRequestParseState::kExpectHeaders;
                 } else {
@@ -76,7 +96,7 @@ bool http::HttpContext::parseRequest(Buffer* buf,
             if (crlf) {
                 const char* colon = std::find(buf->peek(), crlf, ':');
                 if (colon != crlf) {
-                    request_.addHeader(buf->peek(), colon, crlf);
+                    request_->addHeader(buf->peek(), colon, crlf);
                 } else {
                     // empty line, end of header
                     state_ = HttpRequestParseState::kExpectBody;
@@ -86,12 +106,31 @@ bool http::HttpContext::parseRequest(Buffer* buf,
                 hasMore = false;
             }
         } else if (state_ == HttpRequestParseState::kExpectBody) {
-            std::string body = buf->retrieveAllAsString();
-            if (!body.empty()) request_.setBody(body);
+            // only Content-Length bytes, the rest is the next request
+            size_t len = 0;
+            if (!parseContentLength(request_->getHeader("Content-Length"),
+                                    &len)) {
+                error_ = HttpResponse::HttpStatusCode::k400BadRequest;
+                return false;
+            }
+            if (len > maxBodySize_) {
+                error_ = HttpResponse::HttpStatusCode::k413PayloadTooLarge;
+                return false;
+            }
+            if (buf->readableBytes() < len) {
+                hasMore = false;
+                continue;
+            }
+            if (len > 0) {
+                request_->setBody(buf->peek(), buf->peek() + len);
+                buf->retrieve(len);
+                request_->parseFormBody();
+            }
 
             state_ = HttpRequestParseState::kGotAll;
             hasMore = false;
         }
     }
+    if (!ok) error_ = HttpResponse::HttpStatusCode::k400BadRequest;
     return ok;
 }
@@ -0,0 +1,126 @@
+/**
+ * @file HttpRange.cc
+ * @brief
+ *
+ * @author Lux
+ */
+
+#include <LuteBase.h>
+#include <http/HttpRange.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+
+using namespace Lute;
+using namespace Lute::http;
+
+namespace {
+
+/// Without the "W/" of a weak entity tag.
+std::string_view opaqueTag(std::string_view etag) {
+    if (etag.size() > 2 && etag[0] == 'W' && etag[1] == '/') {
+        etag.remove_prefix(2);
+    }
+    return etag;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+/// Digits only, saturates at SIZE_MAX: a position past any body is still
+/// past it, a suffix longer than any body is still the whole body.
+bool parseUint(const char* begin, const char* end, size_t* value) {
+    if (begin == end) return false;
+    size_t v = 0;
+    for (const char* p = begin; p != end; ++p) {
+        if (!isdigit(static_cast<unsigned char>(*p))) return false;
+        const size_t digit = static_cast<size_t>(*p - '0');
+        v = v > (SIZE_MAX - digit) / 10 ? SIZE_MAX : v * 10 + digit;
+    }
+    *value = v;
+    return true;
+}
+
+}  // namespace
+
+time_t http::parseHttpDate(std::string_view date) {
+    // strptime() wants a C string, an IMF-fixdate has 29 characters
+    char buf[64];
+    if (date.size() >= sizeof(buf)) return -1;
+    ::memcpy(buf, date.data(), date.size());
+    buf[date.size()] = '\0';
+
+    struct tm tm;
+    memZero(&tm, sizeof(tm));
+    const char* end = ::strptime(buf, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return end == nullptr || *end != '\0' ? -1 : ::timegm(&tm);
+}
+
+bool http::etagMatches(std::string_view ifNoneMatch, std::string_view etag) {
+    const std::string_view tag = opaqueTag(etag);
+    while (!ifNoneMatch.empty()) {
+        const size_t comma = ifNoneMatch.find(',');
+        const std::string_view member = trim(ifNoneMatch.substr(0, comma));
+        if (member == "*" || (!tag.empty() && opaqueTag(member) == tag)) {
+            return true;
+        }
+        if (comma == std::string_view::npos) break;
+        ifNoneMatch.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+bool http::ifRangeMatches(std::string_view ifRange, std::string_view etag,
+                          std::string_view lastModified) {
+    ifRange = trim(ifRange);
+    if (ifRange.empty()) return true;
+    // a weak tag never matches
+    if (ifRange.front() == '"' || ifRange.compare(0, 2, "W/") == 0) {
+        return ifRange == etag && opaqueTag(etag) == etag;
+    }
+    return ifRange == lastModified;
+}
+
+RangeResult http::parseRange(std::string_view range, size_t size,
+                             size_t* offset, size_t* len) {
+    static const char kBytes[] = "bytes=";
+    if (range.compare(0, sizeof(kBytes) - 1, kBytes) != 0 ||
+        range.find(',') != std::string_view::npos)
+        return RangeResult::kNone;
+
+    const char* begin = range.data() + sizeof(kBytes) - 1;
+    const char* end = range.data() + range.size();
+    const char* dash = std::find(begin, end, '-');
+    if (dash == end) return RangeResult::kNone;
+
+    size_t first = 0, last = 0;
+    bool hasFirst = parseUint(begin, dash, &first);
+    bool hasLast = parseUint(dash + 1, end, &last);
+    if ((!hasFirst && begin != dash) || (!hasLast && dash + 1 != end))
+        return RangeResult::kNone;
+
+    if (!hasFirst) {
+        // suffix range, the last N bytes
+        if (!hasLast) return RangeResult::kNone;
+        if (last == 0 || size == 0) return RangeResult::kUnsatisfiable;
+        *len = std::min(last, size);
+        *offset = size - *len;
+        return RangeResult::kSatisfiable;
+    }
+
+    if (hasLast && last < first) return RangeResult::kNone;
+    if (first >= size) return RangeResult::kUnsatisfiable;
+    if (!hasLast || last >= size) last = size - 1;
+    *offset = first;
+    *len = last - first + 1;
+    return RangeResult::kSatisfiable;
+}
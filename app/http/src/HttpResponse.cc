@@ -8,28 +8,52 @@
 
 using namespace Lute;
 
-void http::HttpResponse::appendToBuffer(Buffer* output) const {
+namespace {
+
+/// Buffer::append(const std::string&) would build a temporary for each.
+template <size_t N>
+void appendLiteral(Buffer* output, const char (&literal)[N]) {
+    output->append(literal, N - 1);
+}
+
+}  // namespace
+
+void http::HttpResponse::appendHeadersToBuffer(Buffer* output) const {
     char buf[32];
-    ::snprintf(buf, sizeof(buf), "HTTP/1.1 %d ", static_cast<int>(statusCode_));
-    output->append(buf);
-    output->append(statusMessage_);
-    output->append("\r\n");
+    int n = ::snprintf(buf, sizeof(buf), "HTTP/1.1 %d ",
+                       static_cast<int>(statusCode_));
+    output->append(buf, static_cast<size_t>(n));
+    output->append(statusMessage_.data(), statusMessage_.size());
+    appendLiteral(output, "\r\n");
 
+    // a 304 has no body, and must not announce one; an unknown length
+    // is chunked, or ends with the close
+    if (chunked()) {
+        appendLiteral(output, "Transfer-Encoding: chunked\r\n");
+    } else if (statusCode_ != HttpStatusCode::k304NotModified &&
+               !(streaming() && streamLength_ < 0)) {
+        n = ::snprintf(buf, sizeof(buf), "Content-Length: %zu\r\n",
+                       streaming() ? static_cast<size_t>(streamLength_)
+                                   : bodySize());
+        output->append(buf, static_cast<size_t>(n));
+    }
     if (closeConnection_) {
-        output->append("Connection: close\r\n");
+        appendLiteral(output, "Connection: close\r\n");
     } else {
-        snprintf(buf, sizeof buf, "Content-Length: %zd\r\n", body_.size());
-        output->append(buf);
-        output->append("Connection: Keep-Alive\r\n");
+        appendLiteral(output, "Connection: Keep-Alive\r\n");
     }
 
     for (const auto& header : headers_) {
-        output->append(header.first);
-        output->append(": ");
-        output->append(header.second);
-        output->append("\r\n");
+        output->append(header.first.data(), header.first.size());
+        appendLiteral(output, ": ");
+        output->append(header.second.data(), header.second.size());
+        appendLiteral(output, "\r\n");
     }
 
-    output->append("\r\n");
-    output->append(body_);
+    appendLiteral(output, "\r\n");
+}
+
+void http::HttpResponse::appendToBuffer(Buffer* output) const {
+    appendHeadersToBuffer(output);
+    output->append(bodyData(), bodySize());
 }
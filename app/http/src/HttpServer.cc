@@ -14,6 +14,27 @@
 using namespace Lute;
 using namespace Lute::http;
 
+namespace {
+
+// reused for every response of the loop
+thread_local Buffer t_responseBuffer;
+// a large body once should not pin its memory for good
+const size_t kResponseBufferMaxCapacity = 64 * 1024;
+// pieces of streamed bodies
+thread_local Buffer t_streamBuffer;
+// room for the chunk size line, "%zx\r\n"
+const char kChunkHeaderRoom[18] = {};
+
+/// HTTP/1.0 knows no chunked coding, the end of the body is the close.
+void closeUnframedStream(const HttpRequest& req, HttpResponse* resp) {
+    if (resp->streaming() && resp->streamLength() < 0 &&
+        req.getVersion() == HttpRequest::Version::kHttp10) {
+        resp->setCloseConnection(true);
+    }
+}
+
+}  // namespace
+
 namespace Lute {
 namespace http {
     namespace detail {
@@ -29,12 +50,18 @@ namespace http {
 HttpServer::HttpServer(EventLoop* loop, const InetAddress& listenAddr,
                        const std::string& name, TCPServer::Option option)
     : server_(loop, listenAddr, name, option),
-      httpCallback_(detail::defaultHttpCallback) {
+      httpCallback_(detail::defaultHttpCallback),
+      workerPool_(nullptr),
+      maxPending_(kDefaultMaxPending),
+      maxBodySize_(kDefaultMaxBodySize) {
     server_.setConnectionCallback(
         std::bind(&HttpServer::onConnection, this, std::placeholders::_1));
     server_.setMessageCallback(
         std::bind(&HttpServer::onMessage, this, std::placeholders::_1,
                   std::placeholders::_2, std::placeholders::_3));
+    server_.setWriteCompleteCallback(std::bind(
+        &HttpServer::onWriteCompleteCallback, this, std::placeholders::_1));
+    server_.setFlowControl(kDefaultFlowHighMark, kDefaultFlowLowMark);
 }
 
 void HttpServer::start() {
@@ -45,7 +72,9 @@ void HttpServer::start() {
 
 void HttpServer::onConnection(const TCPConnectionPtr& conn) {
     if (conn->connected()) {
-        conn->setContext(HttpContext());
+        HttpContext context;
+        context.setMaxBodySize(maxBodySize_);
+        conn->setContext(context);
     }
 }
 
@@ -53,31 +82,235 @@ void HttpServer::onMessage(const TCPConnectionPtr& conn, Buffer* buf,
                            Timestamp receiveTime) {
     HttpContext* context =
         Lute::any_cast<HttpContext>(conn->getMutableContext());
+    // pipelined requests, one at a time
+    do {
+        // resumed by onDeferredDone()
+        if (context->pending()) return;
+        // resumed by the connection once its output drains
+        if (conn->flowPaused()) return;
 
-    // parse request
-    if (!context->parseRequest(buf, receiveTime)) {
-        conn->send("HTTP/1.1 400 Bad Request\r\n\r\n");
-        conn->shutdown();
-    }
+        // parse request
+        if (!context->parseRequest(buf, receiveTime)) {
+            conn->send(context->error() ==
+                               HttpResponse::HttpStatusCode::k413PayloadTooLarge
+                           ? "HTTP/1.1 413 Payload Too Large\r\n\r\n"
+                           : "HTTP/1.1 400 Bad Request\r\n\r\n");
+            conn->shutdown();
+            return;
+        }
 
-    if (context->gotAll()) {
+        if (!context->gotAll()) return;
         onRequest(conn, context->request());
         context->reset();
-    }
+    } while (buf->readableBytes() > 0 && conn->connected());
 }
 
-void HttpServer::onRequest(const TCPConnectionPtr& conn,
-                           const HttpRequest& req) {
-    const std::string& connection = req.getHeader("Connection");
+void HttpServer::onRequest(const TCPConnectionPtr& conn, HttpRequest& req) {
+    const std::string_view connection = req.getHeader("Connection");
     bool close = connection == "close" ||
                  (req.getVersion() == HttpRequest::Version::kHttp10 &&
                   connection != "Keep-Alive");
-    HttpResponse response(close);
+    // from the request's arena, gone before the caller resets the context
+    HttpResponse response(close, req.get_allocator());
+    response.setHeadersOnly(req.method() == HttpRequest::Method::kHead);
     httpCallback_(req, &response);
-    Buffer buf;
-    response.appendToBuffer(&buf);
-    conn->send(&buf);
+    closeUnframedStream(req, &response);
+    if (response.deferred()) {
+        runDeferred(conn, req, response);
+    } else {
+        sendResponse(conn, response);
+    }
+}
+
+void HttpServer::runDeferred(const TCPConnectionPtr& conn, HttpRequest& req,
+                             HttpResponse& response) {
+    HttpResponse::DeferredCallback cb = response.takeDeferred();
+    HttpResponse::AsyncCallback async = response.takeAsync();
+    if (cb && workerPool_ == nullptr) {
+        cb(req, &response);
+        sendResponse(conn, response);
+        return;
+    }
+
+    // backpressure, shed load instead of queueing without bound
+    if (numPending_.incrementAndGet() > maxPending_) {
+        numPending_.decrement();
+        LOG_WARN << "HttpServer[" << server_.name() << "] "
+                 << "too many pending requests, " << conn->name();
+        HttpResponse busy(true);
+        busy.setStatusCode(HttpResponse::HttpStatusCode::k503ServiceUnavailable);
+        busy.setStatusMessage("Service Unavailable");
+        busy.addHeader("Retry-After", "1");
+        sendResponse(conn, busy);
+        return;
+    }
+
+    HttpContext* context =
+        Lute::any_cast<HttpContext>(conn->getMutableContext());
+    context->setPending(true);
+    // the next requests wait in the kernel, not in inputBuffer
+    conn->stopRead();
+
+    // the arena is rewound by the caller, the callback keeps heap copies
+    auto request =
+        std::make_shared<HttpRequest>(req, HttpRequest::allocator_type());
+    auto pending = std::make_shared<HttpResponse>(
+        response, HttpResponse::allocator_type());
+    // queued, not run, even when called in the loop: the caller of
+    // onRequest() still has to reset the context
+    HttpResponse::Done done = [this, conn, request, pending] {
+        closeUnframedStream(*request, pending.get());
+        conn->getLoop()->queueInLoop(
+            std::bind(&HttpServer::onDeferredDone, this, conn, pending));
+    };
+
+    if (async) {
+        async(*request, pending.get(), done);
+    } else {
+        workerPool_->run([request, pending, cb, done] {
+            cb(*request, pending.get());
+            done();
+        });
+    }
+}
+
+void HttpServer::onDeferredDone(const TCPConnectionPtr& conn,
+                                const std::shared_ptr<HttpResponse>& response) {
+    numPending_.decrement();
+    HttpContext* context =
+        Lute::any_cast<HttpContext>(conn->getMutableContext());
+    context->setPending(false);
+    if (!conn->connected()) return;
+
+    // before the response, whose write may pause reading again
+    if (!response->streaming()) conn->startRead();
+    sendResponse(conn, *response);
+
+    // requests that arrived meanwhile
+    if (!response->closeConnection() &&
+        conn->inputBuffer()->readableBytes() > 0) {
+        onMessage(conn, conn->inputBuffer(), conn->getLoop()->now());
+    }
+}
+
+void HttpServer::sendResponse(const TCPConnectionPtr& conn,
+                              HttpResponse& response) {
+    Buffer& buf = t_responseBuffer;
+    if (response.streaming() && !response.headersOnly()) {
+        // the body follows piece by piece from onWriteCompleteCallback(),
+        // which the headers' write triggers
+        HttpContext* context =
+            Lute::any_cast<HttpContext>(conn->getMutableContext());
+        response.appendHeadersToBuffer(&buf);
+        context->setPending(true);
+        conn->stopRead();
+        context->startStream(response.takeBodyStream(),
+                             response.streamLength(), response.chunked(),
+                             response.closeConnection());
+        conn->send(&buf);
+        buf.retrieveAll();
+        return;
+    }
+
+    if (response.headersOnly()) {
+        // a HEAD, the producer of a streamed body is dropped unused
+        response.appendHeadersToBuffer(&buf);
+        conn->send(&buf);
+    } else if (response.hasSharedBody() &&
+               response.bodySize() >= kZeroCopyBodySize) {
+        response.appendHeadersToBuffer(&buf);
+        conn->send(&buf);
+        // written to the socket straight from the FileCache entry,
+        // only what the kernel does not take is copied to outputBuffer_
+        conn->send(response.bodyData(), static_cast<int>(response.bodySize()));
+    } else {
+        response.appendToBuffer(&buf);
+        conn->send(&buf);
+    }
+    // send() leaves it alone once the connection is going down
+    buf.retrieveAll();
+    if (buf.internalCapacity() > kResponseBufferMaxCapacity) buf.shrink(0);
     if (response.closeConnection()) {
         conn->shutdown();
     }
 }
+
+void HttpServer::onWriteCompleteCallback(const TCPConnectionPtr& conn) {
+    pumpStream(conn);
+}
+
+void HttpServer::pumpStream(const TCPConnectionPtr& conn) {
+    HttpContext* context =
+        Lute::any_cast<HttpContext>(conn->getMutableContext());
+    if (!context->streaming()) return;
+    if (!conn->connected()) {
+        context->stopStream();
+        return;
+    }
+    // a slow reader, its write completion calls again
+    if (conn->outputBuffer()->readableBytes() >= kStreamHighWaterMark) return;
+
+    Buffer& buf = t_streamBuffer;
+    buf.retrieveAll();
+    const bool chunked = context->chunked();
+    if (chunked) buf.append(kChunkHeaderRoom, sizeof(kChunkHeaderRoom));
+    const bool more = context->producer()(&buf);
+
+    const size_t len =
+        buf.readableBytes() - (chunked ? sizeof(kChunkHeaderRoom) : 0);
+    if (len == 0) {
+        buf.retrieveAll();
+        if (more) {
+            // nothing ready and nothing written, so no completion to wait
+            // on; a timer, not the next iteration, or the loop would spin
+            const double delay = context->backOffStream(kStreamRetryDelay,
+                                                        kStreamMaxRetryDelay);
+            conn->getLoop()->runAfter(
+                delay, std::bind(&HttpServer::pumpStream, this, conn));
+        } else {
+            finishStream(conn);
+        }
+        return;
+    }
+
+    if (chunked) {
+        // the size line goes into the room left in front of the piece
+        buf.retrieve(sizeof(kChunkHeaderRoom));
+        char line[sizeof(kChunkHeaderRoom)];
+        int n = ::snprintf(line, sizeof(line), "%zx\r\n", len);
+        buf.prepend(line, static_cast<size_t>(n));
+        buf.append("\r\n", 2);
+    }
+    context->streamed(len);
+    // one piece per write completion, so at most one is in flight
+    conn->send(&buf);
+    buf.retrieveAll();
+
+    if (!more) finishStream(conn);
+}
+
+void HttpServer::finishStream(const TCPConnectionPtr& conn) {
+    HttpContext* context =
+        Lute::any_cast<HttpContext>(conn->getMutableContext());
+    bool close = context->closeAfterStream();
+    if (context->chunked()) conn->send("0\r\n\r\n", 5);
+    if (context->streamLength() >= 0 &&
+        context->streamSent() != context->streamLength()) {
+        // the client could not tell where this body ends
+        LOG_ERROR << "HttpServer[" << server_.name() << "] streamed "
+                  << context->streamSent() << " bytes, Content-Length is "
+                  << context->streamLength() << ", " << conn->name();
+        close = true;
+    }
+    context->stopStream();
+    context->setPending(false);
+
+    // also to see the peer's close after our shutdown
+    conn->startRead();
+    if (close) {
+        conn->shutdown();
+    } else if (conn->inputBuffer()->readableBytes() > 0) {
+        // requests that arrived meanwhile
+        onMessage(conn, conn->inputBuffer(), conn->getLoop()->now());
+    }
+}
@@ -0,0 +1,191 @@
+/**
+ * @file Router.cc
+ * @brief
+ *
+ * @author Lux
+ */
+
+#include <http/Router.h>
+
+#include <cassert>
+
+using namespace Lute;
+using namespace Lute::http;
+
+const int Router::kMaxParams;
+const size_t Router::kNumMethods;
+
+const Router::Handler* Router::Route::find(HttpRequest::Method method) const {
+    const Handler& handler = handlers[static_cast<size_t>(method)];
+    if (handler) return &handler;
+
+    // HEAD is answered like GET
+    if (method == HttpRequest::Method::kHead) {
+        const Handler& get =
+            handlers[static_cast<size_t>(HttpRequest::Method::kGet)];
+        if (get) return &get;
+    }
+    return nullptr;
+}
+
+void Router::add(HttpRequest::Method method, const std::string& pattern,
+                 Handler handler) {
+    assert(!pattern.empty() && pattern[0] == '/');
+    const size_t index = static_cast<size_t>(method);
+
+    if (pattern.find_first_of(":*") == std::string::npos) {
+        auto it = exact_.find(pattern);
+        if (it == exact_.end()) {
+            patterns_.push_back(pattern);
+            it = exact_.emplace(patterns_.back(), Route()).first;
+        }
+        it->second.handlers[index] = std::move(handler);
+        return;
+    }
+
+    Node* node = &root_;
+    int numParams = 0;
+    size_t pos = 1;
+    for (;;) {
+        size_t slash = pattern.find('/', pos);
+        if (slash == std::string::npos) slash = pattern.size();
+        std::string segment = pattern.substr(pos, slash - pos);
+
+        if (!segment.empty() && segment[0] == ':') {
+            if (!node->param) {
+                node->param.reset(new Node);
+                node->paramName = segment.substr(1);
+            }
+            assert(node->paramName == segment.substr(1));
+            node = node->param.get();
+            ++numParams;
+        } else if (!segment.empty() && segment[0] == '*') {
+            // catches the rest of the path, must be the last segment
+            assert(slash == pattern.size());
+            if (!node->wildcard) {
+                node->wildcard.reset(new Node);
+                node->wildcardName = segment.substr(1);
+            }
+            node = node->wildcard.get();
+            ++numParams;
+        } else {
+            Node* next = nullptr;
+            for (const auto& child : node->children) {
+                if (child->segment == segment) {
+                    next = child.get();
+                    break;
+                }
+            }
+            if (next == nullptr) {
+                node->children.emplace_back(new Node);
+                next = node->children.back().get();
+                next->segment = segment;
+            }
+            node = next;
+        }
+
+        if (slash == pattern.size()) break;
+        pos = slash + 1;
+    }
+
+    assert(numParams <= kMaxParams);
+    (void)numParams;
+    if (!node->route) node->route.reset(new Route);
+    node->route->handlers[index] = std::move(handler);
+}
+
+void Router::addExtension(HttpRequest::Method method,
+                          const std::string& extension, Handler handler) {
+    const size_t index = static_cast<size_t>(method);
+    for (auto& ext : extensions_) {
+        if (ext.first == extension) {
+            ext.second.handlers[index] = std::move(handler);
+            return;
+        }
+    }
+    extensions_.emplace_back(extension, Route());
+    extensions_.back().second.handlers[index] = std::move(handler);
+}
+
+/// @param path the rest of the request path, after a '/'
+bool Router::match(const Node* node, std::string_view path,
+                   HttpRequest::Method method, Params* params,
+                   const Handler** handler) const {
+    const size_t slash = path.find('/');
+    const bool last = slash == std::string_view::npos;
+    const std::string_view segment = path.substr(0, slash);
+    const std::string_view rest =
+        last ? std::string_view() : path.substr(slash + 1);
+
+    // static segments first
+    for (const auto& child : node->children) {
+        if (child->segment != segment) continue;
+        if (last) {
+            if (child->route && (*handler = child->route->find(method)))
+                return true;
+        } else if (match(child.get(), rest, method, params, handler)) {
+            return true;
+        }
+        break;
+    }
+
+    // then ":param", which never matches an empty segment
+    if (node->param && !segment.empty()) {
+        const int saved = params->size_;
+        params->push(node->paramName, segment);
+        const Node* child = node->param.get();
+        if (last) {
+            if (child->route && (*handler = child->route->find(method)))
+                return true;
+        } else if (match(child, rest, method, params, handler)) {
+            return true;
+        }
+        params->size_ = saved;
+    }
+
+    // "*rest" takes everything left
+    if (node->wildcard && node->wildcard->route &&
+        (*handler = node->wildcard->route->find(method))) {
+        params->push(node->wildcardName, path);
+        return true;
+    }
+    return false;
+}
+
+const Router::Route* Router::findExtension(std::string_view path) const {
+    for (const auto& ext : extensions_) {
+        if (path.size() >= ext.first.size() &&
+            path.compare(path.size() - ext.first.size(), ext.first.size(),
+                         ext.first) == 0)
+            return &ext.second;
+    }
+    return nullptr;
+}
+
+bool Router::route(const HttpRequest& req, HttpResponse* resp) const {
+    Params params;
+    const Handler* handler = nullptr;
+    const std::string_view path = req.path();
+
+    auto it = exact_.find(path);
+    if (it != exact_.end()) handler = it->second.find(req.method());
+
+    if (handler == nullptr && !path.empty() && path[0] == '/' &&
+        !match(&root_, std::string_view(path).substr(1), req.method(),
+               &params, &handler)) {
+        handler = nullptr;
+    }
+
+    if (handler == nullptr) {
+        const Route* route = findExtension(path);
+        if (route) handler = route->find(req.method());
+    }
+
+    if (handler) {
+        (*handler)(req, params, resp);
+        return true;
+    }
+
+    if (notFound_) notFound_(req, params, resp);
+    return false;
+}
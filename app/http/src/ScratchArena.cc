@@ -0,0 +1,57 @@
+/**
+ * @file ScratchArena.cc
+ * @brief
+ *
+ * @author Lux
+ */
+
+#include <http/ScratchArena.h>
+
+#include <cstdint>
+#include <cstring>
+
+using namespace Lute;
+using namespace Lute::http;
+
+const size_t ScratchArena::kSize;
+
+ScratchArena& ScratchArena::current() {
+    // created on first use, threads that never serve a request pay nothing
+    thread_local std::unique_ptr<ScratchArena> t_arena;
+    if (!t_arena) t_arena.reset(new ScratchArena);
+    return *t_arena;
+}
+
+void ScratchArena::rewind(size_t mark) {
+    used_ = mark;
+    if (used_ == 0) overflow_.clear();
+}
+
+char* ScratchArena::allocate(size_t n, size_t align) {
+    const uintptr_t base = reinterpret_cast<uintptr_t>(buffer_);
+    const uintptr_t aligned = (base + used_ + align - 1) & ~(align - 1);
+    const size_t offset = aligned - base;
+    if (offset <= kSize && n <= kSize - offset) {
+        used_ = offset + n;
+        return buffer_ + offset;
+    }
+
+    // operator new[] aligns for any fundamental type
+    overflow_.emplace_back(new char[n]);
+    return overflow_.back().get();
+}
+
+std::string_view ScratchArena::concat(
+    std::initializer_list<std::string_view> parts) {
+    size_t len = 0;
+    for (std::string_view part : parts) len += part.size();
+
+    char* p = allocate(len + 1, 1);
+    char* end = p;
+    for (std::string_view part : parts) {
+        ::memcpy(end, part.data(), part.size());
+        end += part.size();
+    }
+    *end = '\0';
+    return std::string_view(p, len);
+}
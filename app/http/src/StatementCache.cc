@@ -0,0 +1,68 @@
+/**
+ * @file StatementCache.cc
+ * @brief
+ *
+ * @author Lux
+ */
+
+#include <http/StatementCache.h>
+
+using namespace Lute;
+using namespace Lute::http;
+
+namespace {
+
+// from errmsg.h and mysqld_error.h
+const unsigned int kServerGoneError = 2006;
+const unsigned int kServerLost = 2013;
+const unsigned int kUnknownStmtHandler = 1243;
+
+}  // namespace
+
+StatementCache::~StatementCache() {
+    for (auto& conn : connections_) {
+        for (auto& stmt : conn.second) ::mysql_stmt_close(stmt.second);
+    }
+}
+
+MYSQL_STMT* StatementCache::get(MYSQL* mysql, const std::string& sql) {
+    {
+        MutexLockGuard lock(mutex_);
+        Statements& statements = connections_[mysql];
+        auto it = statements.find(sql);
+        if (it != statements.end()) return it->second;
+    }
+
+    // prepare outside the lock, the connection is ours meanwhile
+    MYSQL_STMT* stmt = ::mysql_stmt_init(mysql);
+    if (stmt == nullptr) {
+        LOG_ERROR << "mysql_stmt_init: " << ::mysql_error(mysql);
+        return nullptr;
+    }
+    if (::mysql_stmt_prepare(stmt, sql.data(), sql.size()) != 0) {
+        LOG_ERROR << "mysql_stmt_prepare: " << ::mysql_stmt_error(stmt);
+        ::mysql_stmt_close(stmt);
+        return nullptr;
+    }
+
+    MutexLockGuard lock(mutex_);
+    connections_[mysql][sql] = stmt;
+    return stmt;
+}
+
+void StatementCache::invalidate(MYSQL* mysql) {
+    Statements statements;
+    {
+        MutexLockGuard lock(mutex_);
+        auto it = connections_.find(mysql);
+        if (it == connections_.end()) return;
+        statements.swap(it->second);
+        connections_.erase(it);
+    }
+    for (auto& stmt : statements) ::mysql_stmt_close(stmt.second);
+}
+
+bool StatementCache::isConnectionLost(unsigned int error) {
+    return error == kServerGoneError || error == kServerLost ||
+           error == kUnknownStmtHandler;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file UserInserter.cc
+ * @brief
+ *
+ * @author Lux
+ */
+
+#include <http/UserInserter.h>
+
+using namespace Lute;
+using namespace Lute::http;
+
+const size_t UserInserter::kMaxBatch;
+
+UserInserter::UserInserter(AsyncMySQLPool* pool)
+    : pool_(pool),
+      thread_(EventLoopThread::ThreadInitCallback(), "UserInserter"),
+      loop_(nullptr),
+      flushQueued_(false),
+      inFlight_(0),
+      drained_(nullptr) {
+    pool_->setCloseCallback(
+        [this](MYSQL* mysql) { statements_.invalidate(mysql); });
+}
+
+UserInserter::~UserInserter() {
+    if (loop_ != nullptr) {
+        CountDownLatch latch(1);
+        loop_->runInLoop([this, &latch] {
+            drained_ = &latch;
+            flushQueue();
+            if (inFlight_ == 0) latch.countDown();
+        });
+        latch.wait();
+    }
+    // the pool may outlive us, and closes its idle connections last
+    pool_->setCloseCallback(AsyncMySQLPool::CloseCallback());
+}
+
+void UserInserter::start() { loop_ = thread_.startLoop(); }
+
+void UserInserter::insert(const std::string& username,
+                          const std::string& mail, const std::string& passwd,
+                          Callback cb) {
+    auto row =
+        std::make_shared<Row>(Row{username, mail, passwd, std::move(cb)});
+    loop_->runInLoop([this, row] { enqueue(*row); });
+}
+
+void UserInserter::enqueue(Row& row) {
+    loop_->assertInLoopThread();
+    queue_.push_back(std::move(row));
+    if (queue_.size() >= kMaxBatch) {
+        flushQueue();
+    } else if (!flushQueued_) {
+        // let concurrent registrations join the batch
+        flushQueued_ = true;
+        loop_->runAfter(kWindow, [this] {
+            flushQueued_ = false;
+            flushQueue();
+        });
+    }
+}
+
+void UserInserter::flushQueue() {
+    loop_->assertInLoopThread();
+    while (!queue_.empty()) {
+        auto rows = std::make_shared<Rows>();
+        if (queue_.size() <= kMaxBatch) {
+            rows->swap(queue_);
+        } else {
+            auto end = queue_.begin() + kMaxBatch;
+            rows->assign(std::make_move_iterator(queue_.begin()),
+                         std::make_move_iterator(end));
+            queue_.erase(queue_.begin(), end);
+        }
+
+        ++inFlight_;
+        pool_->acquire(loop_,
+                       [this, rows](const AsyncMySQLPool::LeasePtr& lease) {
+                           flush(rows, lease);
+                       });
+    }
+}
+
+void UserInserter::flush(const RowsPtr& rowsPtr,
+                         const AsyncMySQLPool::LeasePtr& lease) {
+    loop_->assertInLoopThread();
+    Rows& rows = *rowsPtr;
+    if (!lease) {
+        LOG_ERROR << "UserInserter gets no connection for " << rows.size()
+                  << " users";
+        for (Row& row : rows) row.cb(false);
+        finishBatch();
+        return;
+    }
+
+    if (execute(*lease, rows, 0, rows.size())) {
+        LOG_DEBUG << "UserInserter inserts " << rows.size() << " users";
+        for (Row& row : rows) row.cb(true);
+    } else {
+        // one bad row fails the statement, find out which
+        for (size_t i = 0; i < rows.size(); ++i) {
+            rows[i].cb(rows.size() > 1 && execute(*lease, rows, i, 1));
+        }
+    }
+    finishBatch();
+}
+
+void UserInserter::finishBatch() {
+    --inFlight_;
+    if (drained_ && inFlight_ == 0 && queue_.empty()) drained_->countDown();
+}
+
+bool UserInserter::execute(AsyncMySQLPool::Lease& lease, const Rows& rows,
+                           size_t begin, size_t n) {
+    MYSQL* mysql = lease.get();
+    const std::string sql = insertSql(n);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        MYSQL_STMT* stmt = statements_.get(mysql, sql);
+        if (stmt == nullptr) return false;
+
+        std::vector<MYSQL_BIND> binds(3 * n);
+        std::vector<unsigned long> lengths(3 * n);
+        memZero(binds.data(), binds.size() * sizeof(MYSQL_BIND));
+        for (size_t i = 0; i < n; ++i) {
+            const Row& row = rows[begin + i];
+            const std::string* fields[] = {&row.username, &row.mail,
+                                           &row.passwd};
+            for (size_t j = 0; j < 3; ++j) {
+                MYSQL_BIND& bind = binds[3 * i + j];
+                lengths[3 * i + j] = fields[j]->size();
+                bind.buffer_type = MYSQL_TYPE_STRING;
+                bind.buffer = const_cast<char*>(fields[j]->data());
+                bind.buffer_length = fields[j]->size();
+                bind.length = &lengths[3 * i + j];
+            }
+        }
+
+        if (!::mysql_stmt_bind_param(stmt, binds.data()) &&
+            ::mysql_stmt_execute(stmt) == 0) {
+            return true;
+        }
+
+        const unsigned int error = ::mysql_stmt_errno(stmt);
+        LOG_ERROR << "UserInserter INSERT " << n
+                  << " rows: " << ::mysql_stmt_error(stmt);
+        if (!StatementCache::isConnectionLost(error)) break;
+        // a forgotten statement is prepared again once, a dead connection
+        // is left to the pool to replace
+        statements_.invalidate(mysql);
+        if (attempt == 1 || ::mysql_ping(mysql) != 0) {
+            lease.markBroken();
+            break;
+        }
+    }
+    return false;
+}
+
+std::string UserInserter::insertSql(size_t n) {
+    std::string sql = "INSERT INTO user(username, mail, passwd) VALUES ";
+    for (size_t i = 0; i < n; ++i) {
+        sql += i == 0 ? "(?, ?, ?)" : ", (?, ?, ?)";
+    }
+    return sql;
+}
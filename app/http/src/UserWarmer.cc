@@ -0,0 +1,211 @@
+/**
+ * @file UserWarmer.cc
+ * @brief
+ *
+ * @author Lux
+ */
+
+#include <http/CredentialCache.h>
+#include <http/UserWarmer.h>
+
+#include <algorithm>
+
+using namespace Lute;
+using namespace Lute::http;
+using namespace Lute::mysql;
+
+namespace {
+
+/// For a value inside single quotes
+std::string escapeSql(const std::string& s) {
+    std::string escaped;
+    escaped.reserve(s.size());
+    for (char c : s) {
+        if (c == '\'' || c == '\\') escaped.push_back(c);
+        escaped.push_back(c);
+    }
+    return escaped;
+}
+
+}  // namespace
+
+const int UserWarmer::kChunkSize;
+const int UserWarmer::kBatchSize;
+
+UserWarmer::UserWarmer(MySQLConnPool* connPool, const InetAddress& redisAddr,
+                       const std::string& hashKey, CredentialCache* cache)
+    : connPool_(connPool),
+      redisAddr_(redisAddr),
+      hashKey_(hashKey),
+      cache_(cache),
+      thread_(std::bind(&UserWarmer::run, this), "UserWarmer"),
+      redisThread_(EventLoopThread::ThreadInitCallback(), "UserWarmerRedis"),
+      redisLoop_(nullptr),
+      stop_(false),
+      done_(false),
+      cond_(mutex_),
+      inFlight_(0),
+      numErrors_(0) {}
+
+UserWarmer::~UserWarmer() {
+    stop_ = true;
+    {
+        MutexLockGuard lock(mutex_);
+        cond_.notifyAll();
+    }
+    if (thread_.started()) thread_.join();
+}
+
+void UserWarmer::start() { thread_.start(); }
+
+void UserWarmer::run() {
+    redisLoop_ = redisThread_.startLoop();
+    {
+        CountDownLatch latch(1);
+        redisLoop_->runInLoop([this, &latch] {
+            redis_.reset(new AsyncRedisClient(redisLoop_, redisAddr_,
+                                              "UserWarmerRedis"));
+            redis_->connect();
+            latch.countDown();
+        });
+        latch.wait();
+    }
+
+    const Timestamp start = Timestamp::now();
+    int64_t numUsers = 0;
+    // the rest only goes to Redis, evicting would just churn the cache
+    bool cacheFull = false;
+    std::string last;
+    for (;;) {
+        Rows rows;
+        const bool loaded = loadChunk(last, &rows);
+        // the previous chunk went to Redis while this one was read
+        if (!waitForReplies() || !loaded || rows.empty()) break;
+
+        for (size_t i = 0; i < rows.size() && !cacheFull; ++i) {
+            if (!cache_->tryPut(rows[i].first, rows[i].second)) {
+                LOG_INFO << "UserWarmer filled the credential cache with "
+                         << cache_->size() << " users";
+                cacheFull = true;
+            }
+        }
+        sendChunk(rows);
+        last = rows.back().first;
+        numUsers += static_cast<int64_t>(rows.size());
+
+        const double elapsed = timeDifference(Timestamp::now(), start);
+        LOG_INFO << "UserWarmer loaded " << numUsers << " users, "
+                 << static_cast<int64_t>(elapsed > 0 ? numUsers / elapsed : 0)
+                 << " users/s";
+
+        if (rows.size() < static_cast<size_t>(kChunkSize)) {
+            waitForReplies();
+            break;
+        }
+    }
+
+    {
+        MutexLockGuard lock(mutex_);
+        LOG_INFO << "UserWarmer " << (stop_ ? "stopped" : "finished") << ", "
+                 << numUsers << " users in "
+                 << timeDifference(Timestamp::now(), start) << "s, "
+                 << numErrors_ << " failed batches";
+    }
+    done_ = true;
+
+    // let the connection close in its loop before the client goes
+    CountDownLatch closed(1);
+    redisLoop_->runInLoop([this, &closed] {
+        if (!redis_->connected()) {
+            closed.countDown();
+            return;
+        }
+        redis_->setConnectCallback([&closed](bool connected) {
+            if (!connected) closed.countDown();
+        });
+        redis_->disconnect();
+    });
+    closed.wait();
+
+    CountDownLatch destroyed(1);
+    redisLoop_->runInLoop([this, &destroyed] {
+        redis_.reset();
+        destroyed.countDown();
+    });
+    destroyed.wait();
+}
+
+bool UserWarmer::loadChunk(const std::string& last, Rows* rows) {
+    // keyset pagination, an OFFSET would rescan every chunk before it
+    const std::string stmt =
+        "SELECT username, passwd FROM user WHERE username > '" +
+        escapeSql(last) + "' ORDER BY username LIMIT " +
+        std::to_string(kChunkSize) + ";";
+
+    MYSQL* mysql = nullptr;
+    MySQLConn conn(mysql, connPool_);
+    conn.execute(stmt.c_str());
+    if (conn.stmtRes_.rc_) {
+        LOG_ERROR << "UserWarmer SELECT error: " << mysql_error(mysql);
+        return false;
+    }
+
+    rows->reserve(conn.stmtRes_.rows_.size());
+    for (auto& row : conn.stmtRes_.rows_) {
+        rows->emplace_back(std::string(row[0]), std::string(row[1]));
+    }
+    return true;
+}
+
+void UserWarmer::sendChunk(const Rows& rows) {
+    auto batches = std::make_shared<std::vector<std::vector<std::string>>>();
+    for (size_t i = 0; i < rows.size(); i += kBatchSize) {
+        std::vector<std::string> args{"HMSET", hashKey_};
+        const size_t end = std::min(rows.size(), i + kBatchSize);
+        args.reserve(2 + 2 * (end - i));
+        for (size_t j = i; j < end; ++j) {
+            args.push_back(rows[j].first);
+            args.push_back(rows[j].second);
+        }
+        batches->push_back(std::move(args));
+    }
+
+    {
+        MutexLockGuard lock(mutex_);
+        inFlight_ += static_cast<int>(batches->size());
+    }
+    auto onReply = [this](const AsyncRedisClient::Reply& reply) {
+        MutexLockGuard lock(mutex_);
+        // given up on by waitForReplies(), and counted already
+        if (inFlight_ == 0) return;
+        if (reply.isError()) {
+            LOG_ERROR << "UserWarmer HMSET error: " << reply.str;
+            ++numErrors_;
+        }
+        if (--inFlight_ == 0) cond_.notifyAll();
+    };
+    // issued in one loop iteration, so they share a write
+    redisLoop_->runInLoop([this, batches, onReply] {
+        for (const auto& args : *batches) redis_->command(args, onReply);
+    });
+}
+
+bool UserWarmer::waitForReplies() {
+    MutexLockGuard lock(mutex_);
+    const double timeout = kBatchTimeout * inFlight_;
+    const Timestamp deadline = addTime(Timestamp::now(), timeout);
+    while (inFlight_ > 0 && !stop_) {
+        const double left = timeDifference(deadline, Timestamp::now());
+        if (left <= 0) {
+            // no more chunks, later replies are ignored
+            LOG_ERROR << "UserWarmer " << inFlight_
+                      << " HMSET batches not answered in " << timeout
+                      << "s, giving up";
+            numErrors_ += inFlight_;
+            inFlight_ = 0;
+            return false;
+        }
+        cond_.waitForSeconds(std::min(left, 1.0));
+    }
+    return !stop_;
+}
@@ -2,11 +2,15 @@
 #include <LuteMySQL.h>
 #include <LutePolaris.h>
 #include <fcntl.h>
+#include <http/HttpRange.h>
 #include <http/app.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cctype>
 #include <cstring>
+#include <ctime>
 #include <iostream>
 #include <memory>
 #include <thread>
@@ -23,6 +27,59 @@ bool benchmark = false;
 // std::map<string, std::pair<string, string>> users;
 const std::string HASH_KEY{"user"};
 
+namespace {
+
+// one blocking connection per worker thread, see Application::redisConn()
+thread_local std::unique_ptr<redis::RedisConn> t_redisConn;
+// one async client per IO loop, see Application::asyncRedis(). Reset in
+// its loop by ~Application(), the thread exit would be after the loop is gone.
+thread_local std::unique_ptr<AsyncRedisClient> t_asyncRedis;
+
+// The fields end up in SQL text and the Redis hash, keep the charsets the
+// forms accepted before.
+bool isWord(std::string_view s, bool underscore) {
+    if (s.empty()) return false;
+    for (char c : s) {
+        if (!::isalnum(static_cast<unsigned char>(c)) &&
+            !(underscore && c == '_'))
+            return false;
+    }
+    return true;
+}
+
+/// e.g. "name@domain.com"
+bool isMail(std::string_view s) {
+    const size_t at = s.find('@');
+    if (at == std::string_view::npos || s.size() < at + 5 ||
+        s.substr(s.size() - 4) != ".com")
+        return false;
+    if (!isWord(s.substr(0, at), false)) return false;
+    std::string_view domain = s.substr(at + 1, s.size() - at - 5);
+    if (domain.empty()) return false;
+    for (char c : domain) {
+        if (!::isalpha(static_cast<unsigned char>(c))) return false;
+    }
+    return true;
+}
+
+AsyncMySQLPool::Options mysqlPoolOptions(const std::string& host,
+                                         uint16_t port, const std::string& user,
+                                         const std::string& passwd,
+                                         const std::string& db) {
+    AsyncMySQLPool::Options options;
+    options.host = host;
+    options.port = port;
+    options.user = user;
+    options.passwd = passwd;
+    options.db = db;
+    return options;
+}
+
+}  // namespace
+
+const uint16_t Application::kRedisPort;
+const int Application::kRedisTimeoutMs;
+
 Application::Application(EventLoop* loop, const InetAddress& listenAddr,
                          const std::string& name, const std::string& root,
                          const std::string& dbIpAddr, uint16_t dbPort,
@@ -31,335 +88,502 @@ Application::Application(EventLoop* loop, const InetAddress& listenAddr,
     : loop_(loop),
       server_(loop, listenAddr, name),
       numThreads_(0),
-      realFile_(),
       serverPath_(root),
-      fileStat_(),
-      fileAddr_(nullptr),
+      workerPool_("worker"),
       dbIpAddr_(dbIpAddr),
       dbPort_(dbPort),
       dbUser_(dbUser),
       dbPasswd_(dbPasswd),
       dbName_(dbName),
-      connPool_(MySQLConnPool::getInstance()) {
+      connPool_(MySQLConnPool::getInstance()),
+      mysqlPool_(
+          mysqlPoolOptions(dbIpAddr, dbPort, dbUser, dbPasswd, dbName)),
+      credentials_(kCredentialTtl, kNegativeCredentialTtl),
+      warmer_(connPool_, InetAddress("127.0.0.1", kRedisPort, false),
+              HASH_KEY, &credentials_),
+      inserter_(&mysqlPool_) {
     (void)loop_;
     (void)numThreads_;
-    (void)fileAddr_;
-
-    memZero(realFile_, FILENAME_LEN);
 
     server_.setHttpCallback(std::bind(&Application::onRequest, this,
                                       std::placeholders::_1,
                                       std::placeholders::_2));
 
+    using namespace std::placeholders;
+    using Method = HttpRequest::Method;
+    router_.add(Method::kGet, "/",
+                std::bind(&Application::onIndex, this, _1, _2, _3));
+    router_.add(Method::kGet, "/index.html",
+                std::bind(&Application::onIndex, this, _1, _2, _3));
+    router_.add(Method::kGet, "/register",
+                std::bind(&Application::onRegister, this, _1, _2, _3));
+    router_.add(Method::kPost, "/register",
+                std::bind(&Application::onRegister, this, _1, _2, _3));
+    router_.add(Method::kGet, "/welcome",
+                std::bind(&Application::onWelcome, this, _1, _2, _3));
+    router_.add(Method::kGet, "/login",
+                std::bind(&Application::onLogin, this, _1, _2, _3));
+    router_.addExtension(Method::kGet, ".jpg",
+                         std::bind(&Application::onImage, this, _1, _2, _3));
+    router_.setNotFound(std::bind(&Application::onNotFound, this, _1, _2, _3));
+
+    // connect to Redis at thread start rather than on the first request
+    server_.setThreadInitCallback([this](EventLoop* loop) {
+        t_asyncRedis.reset(new AsyncRedisClient(
+            loop, InetAddress("127.0.0.1", kRedisPort, false), "redis"));
+        t_asyncRedis->connect();
+        MutexLockGuard lock(redisLoopsMutex_);
+        redisLoops_.push_back(loop);
+    });
+    workerPool_.setThreadInitCallback([] { redisConn(); });
+    workerPool_.start(kNumWorkers);
+    server_.setWorkerPool(&workerPool_);
+    fileCache_.setCompressPool(&workerPool_);
+    fileCache_.startRevalidate(loop_, kRevalidateInterval);
+    // compress the HTML tree at startup rather than on first access
+    fileCache_.preload(serverPath_);
+
     connPool_->init(10, dbIpAddr_, dbPort_, dbUser_, dbPasswd_, dbName_, true,
                     "utf8mb4");
+    mysqlPool_.start();
 
-    MYSQL* mysql = nullptr;
-    MySQLConn conn(mysql, connPool_);
-    conn.execute("SELECT username, mail, passwd FROM user;");
-
-    redisConn_.connectSvr("127.0.0.1", 6379, 1200);
+    inserter_.start();
+    // in the background, the server accepts connections meanwhile
+    warmer_.start();
+}
 
-    for (auto& row : conn.stmtRes_.rows_) {
-        // users[row[0]] = {row[1], row[2]};
-        LOG_DEBUG << row[0] << ", " << row[1] << ", " << row[2];
-        std::string passwd(row[2]);
-        if (redisConn_.setHField(HASH_KEY, std::string(row[0]), passwd) != 0) {
-            LOG_ERROR << "Redis set failed";
-        }
+Application::~Application() {
+    std::vector<EventLoop*> loops;
+    {
+        MutexLockGuard lock(redisLoopsMutex_);
+        loops.swap(redisLoops_);
+    }
+    // each client goes in its own loop, which server_ still runs
+    CountDownLatch latch(static_cast<int>(loops.size()));
+    for (EventLoop* loop : loops) {
+        loop->runInLoop([&latch] {
+            t_asyncRedis.reset();
+            latch.countDown();
+        });
     }
+    latch.wait();
 }
 
 void Application::onRequest(const HttpRequest& req, HttpResponse* resp) {
-    LOG_INFO << "Headers " << req.methodString() << " " << req.path();
-
-    if (req.path() == "/" || req.path() == "/index.html") {
-        resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
-        resp->setStatusMessage("OK");
-        resp->setContentType("text/html");
-        resp->addHeader("Server", "Lux polaris");
-
-        strcpy(realFile_, serverPath_.c_str());
-        int len = ::strlen(realFile_);
-        LOG_INFO << "realFile_ len: " << len;
-
-        const char* index = "/index.html";
-        strcat(realFile_, index);
-
-        resp->setBody(getHtml());
-    } else if (req.path() == "/register") {
-        LOG_INFO << req.path();
-        resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
-        resp->setStatusMessage("OK");
-        resp->setContentType("text/html");
-        resp->addHeader("Server", "Lux polaris");
-        std::string body = req.body();
-
-        if (req.method() == HttpRequest::Method::kPost && !body.empty()) {
-            // 处理注册信息 - user, mail, password
-            std::string username, mail, password;
-            std::regex pattern(
-                "Username=([0-9a-zA-Z_]+)&email=([0-9a-zA-Z]+\\%40[a-zA-Z]+"
-                "\\."
-                "com)&password=([0-9a-zA-Z]+)");
-            for (std::sregex_iterator iter(body.begin(), body.end(), pattern),
-                 iterend;
-                 iter != iterend; ++iter) {
-                username = iter->str(1);
-                mail = iter->str(2);
-                password = iter->str(3);
-            }
-            std::string stmt =
-                "INSERT INTO user(username, mail, passwd) VALUES('" + username +
-                "', '" + mail + "', '" + password + "')";
+    LOG_INFO << "Headers " << req.methodString() << " "
+             << std::string(req.path());
 
-            // if (users.find(username) == users.end()) {
-            std::string pwd;
-            // if (redisConn_.getHField(HASH_KEY, username, pwd) == 0) {
-            if (redisConn_.hasHField(HASH_KEY, username) == 0) {
-                LOG_INFO << "username: " << username << "pwd: " << pwd;
-
-                MYSQL* mysql = nullptr;
-                MySQLConn conn(mysql, connPool_);
-                conn.execute(stmt.c_str());
-
-                // 成功
-                if (!conn.stmtRes_.rc_) {
-                    // users[username] = {mail, password};
-                    redisConn_.setHField(HASH_KEY, username, password);
-                    strcpy(realFile_, serverPath_.c_str());
-                    int len = strlen(realFile_);
-                    LOG_INFO << "realFile_ len: " << len;
-
-                    const char* index = "/welcome.html";
-                    strcat(realFile_, index);
-                } else {
-                    LOG_ERROR << "SELECT error: " << mysql_error(mysql);
+    // handler temporaries go back to the arena with the request
+    ScratchArena::Scope scratch;
+    router_.route(req, resp);
+}
+
+void Application::onIndex(const HttpRequest& req, const Router::Params&,
+                          HttpResponse* resp) {
+    resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setContentType("text/html");
+    resp->addHeader("Server", "Lux polaris");
+
+    setFileBody("/index.html", req, resp);
+}
+
+void Application::onRegister(const HttpRequest& req, const Router::Params&,
+                             HttpResponse* resp) {
+    LOG_INFO << std::string(req.path());
+    resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setContentType("text/html");
+    resp->addHeader("Server", "Lux polaris");
+
+    if (req.method() == HttpRequest::Method::kPost &&
+        !req.formParams().empty()) {
+        // 处理注册信息 - user, mail, password
+        const std::string_view usernameView = req.formParam("Username");
+        const std::string_view mailView = req.formParam("email");
+        const std::string_view passwordView = req.formParam("password");
+        if (!isWord(usernameView, true) || !isMail(mailView) ||
+            !isWord(passwordView, false)) {
+            LOG_WARN << "Invalid register form";
+            setFileBody("/registerFailed.html", req, resp);
+            return;
+        }
+        const std::string username(usernameView), mail(mailView),
+            password(passwordView);
+
+        // nothing here blocks the IO loop: Redis is asked asynchronously and
+        // the INSERT is batched with concurrent ones by inserter_
+        resp->deferInLoop([this, username, mail, password](
+                              const HttpRequest& req, HttpResponse* resp,
+                              const HttpResponse::Done& done) {
+            EventLoop* loop = EventLoop::getEventLoopOfCurrentThread();
+            // done holds req and resp until it is called
+            auto onInserted = [this, loop, &req, resp, done, username,
+                               password](bool ok) {
+                if (ok) storeCredential(loop, username, password);
+                setFileBody(ok ? "/welcome.html" : "/registerFailed.html",
+                            req, resp);
+                done();
+            };
+            auto onChecked = [this, &req, resp, done, username, mail,
+                              password, onInserted](bool exists) {
+                if (exists) {
+                    setFileBody("/registerFailed.html", req, resp);
+                    done();
+                    return;
                 }
-            } else {
-                strcpy(realFile_, serverPath_.c_str());
-                int len = strlen(realFile_);
-                LOG_INFO << "realFile_ len: " << len;
+                LOG_INFO << "username: " << username;
+                inserter_.insert(username, mail, password, onInserted);
+            };
+
+            std::string cached;
+            switch (credentials_.find(username, &cached)) {
+                case CredentialCache::Lookup::kFound:
+                    onChecked(true);
+                    return;
+                case CredentialCache::Lookup::kAbsent:
+                    onChecked(false);
+                    return;
+                default:
+                    break;
+            }
 
-                const char* index = "/registerFailed.html";
-                strcat(realFile_, index);
+            AsyncRedisClient* redis = asyncRedis();
+            if (redis != nullptr && redis->connected()) {
+                redis->hexists(
+                    HASH_KEY, username,
+                    [this, &req, resp, done,
+                     onChecked](const AsyncRedisClient::Reply& r) {
+                        if (r.type == AsyncRedisClient::Reply::kInteger) {
+                            onChecked(r.integer != 0);
+                            return;
+                        }
+                        // e.g. dropped connection, the user may exist
+                        LOG_ERROR << "HEXISTS failed: " << r.str;
+                        resp->setStatusCode(HttpResponse::HttpStatusCode::
+                                                k503ServiceUnavailable);
+                        resp->setStatusMessage("Service Unavailable");
+                        setFileBody("/registerFailed.html", req, resp);
+                        done();
+                    });
+            } else {
+                workerPool_.run([onChecked, username] {
+                    onChecked(redisConn().hasHField(HASH_KEY, username) != 0);
+                });
             }
-        } else {
-            strcpy(realFile_, serverPath_.c_str());
-            int len = strlen(realFile_);
-            LOG_INFO << "realFile_ len: " << len;
+        });
+        return;
+    }
 
-            const char* index = "/register.html";
-            strcat(realFile_, index);
-        }
+    setFileBody("/register.html", req, resp);
+}
 
-        resp->setBody(getHtml());
-    } else if (req.path() == "/welcome") {
-        resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
-        resp->setStatusMessage("OK");
-        resp->setContentType("text/html");
-        resp->addHeader("Server", "Lux polaris");
+void Application::onWelcome(const HttpRequest& req, const Router::Params&,
+                            HttpResponse* resp) {
+    resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setContentType("text/html");
+    resp->addHeader("Server", "Lux polaris");
 
-        strcpy(realFile_, serverPath_.c_str());
-        int len = strlen(realFile_);
-        LOG_INFO << "realFile_ len: " << len;
+    setFileBody("/welcome.html", req, resp);
+}
 
-        const char* index = "/welcome.html";
-        strcat(realFile_, index);
+void Application::onImage(const HttpRequest& req, const Router::Params&,
+                          HttpResponse* resp) {
+    resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setContentType("image/jpg");
+    resp->addHeader("Server", "Lux polaris");
 
-        resp->setBody(getHtml());
+    setFileBody(req.path(), req, resp);
+}
+
+void Application::onLogin(const HttpRequest& req, const Router::Params&,
+                          HttpResponse* resp) {
+    LOG_INFO << std::string(req.path());
+    LOG_INFO << std::string(req.query());
 
-    } else if (req.path().find(".jpg") != std::string::npos) {
-        resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
-        resp->setStatusMessage("OK");
-        resp->setContentType("image/jpg");
-        resp->addHeader("Server", "Lux polaris");
+    std::string username(req.queryParam("Username")),
+        passwd(req.queryParam("password"));
+    if (!isWord(username, true) || !isWord(passwd, false)) {
+        username.clear();
+        passwd.clear();
+    }
 
-        strcpy(realFile_, serverPath_.c_str());
-        int len = strlen(realFile_);
-        LOG_INFO << "realFile_ len: " << len;
+    resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setContentType("text/html");
+    resp->addHeader("Server", "Lux polaris");
+
+    // most logins are answered here, without leaving the IO loop
+    std::string cached;
+    switch (credentials_.find(username, &cached)) {
+        case CredentialCache::Lookup::kFound:
+            setLoginBody(!cached.empty() && cached == passwd, req, resp);
+            return;
+        case CredentialCache::Lookup::kAbsent:
+            setLoginBody(false, req, resp);
+            return;
+        default:
+            break;
+    }
 
-        const char* index = req.path().c_str();
-        strcat(realFile_, index);
+    AsyncRedisClient* redis = asyncRedis();
+    if (redis == nullptr || !redis->connected()) {
+        // no async client on this loop, the blocking one runs on a worker
+        resp->defer([this, username, passwd](const HttpRequest& req,
+                                             HttpResponse* resp) {
+            //  使用 Redis 缓存
+            std::string pwd;
+            redis::RedisConn& redis = redisConn();
+            if (redis.hasHField(HASH_KEY, username)) {
+                redis.getHField(HASH_KEY, username, pwd);
+                credentials_.put(username, pwd);
+            } else if (warmer_.done()) {
+                credentials_.putAbsent(username);
+            }
+            setLoginBody(!pwd.empty() && pwd == passwd, req, resp);
+        });
+        return;
+    }
 
-        LOG_INFO << realFile_;
+    // a single HGET on the IO loop, nil if there is no such user
+    resp->deferInLoop([this, redis, username, passwd](
+                          const HttpRequest& req, HttpResponse* resp,
+                          const HttpResponse::Done& done) {
+        // done holds req and resp until it is called
+        auto onReply = [this, &req, resp, done, username,
+                        passwd](const AsyncRedisClient::Reply& reply) {
+            // errors are not cached
+            if (reply.type == AsyncRedisClient::Reply::kString) {
+                credentials_.put(username, reply.str);
+            } else if (reply.type == AsyncRedisClient::Reply::kNil &&
+                       warmer_.done()) {
+                // during warm-up the user may not be in Redis yet
+                credentials_.putAbsent(username);
+            }
+            const bool ok = reply.type == AsyncRedisClient::Reply::kString &&
+                            !reply.str.empty() && reply.str == passwd;
+            setLoginBody(ok, req, resp);
+            done();
+        };
+        redis->hget(HASH_KEY, username, onReply);
+    });
+}
 
-        // NO resource
-        if (stat(realFile_, &fileStat_) < 0) return;
-        // FORBIDDEN REQUEST
-        if (!(fileStat_.st_mode & S_IROTH)) return;
-        // BAD_REQUEST
-        if (S_ISDIR(fileStat_.st_mode)) return;
+void Application::setLoginBody(bool ok, const HttpRequest& req,
+                               HttpResponse* resp) {
+    setFileBody(ok ? "/welcome.html" : "/loginFailed.html", req, resp);
+}
 
-        std::ifstream ifs(realFile_, std::ios::ios_base::binary);
-        if (!ifs.is_open()) {
-            LOG_ERROR << "Open " << realFile_ << " failed";
-            resp->setBody("");
-        } else {
-            // 将文件读入到ostringstream对象buf中
-            std::ostringstream buf{};
-            char ch;
-            while (buf && ifs.get(ch)) buf.put(ch);
+void Application::onNotFound(const HttpRequest& req, const Router::Params&,
+                             HttpResponse* resp) {
+    resp->setStatusCode(HttpResponse::HttpStatusCode::k404NotFound);
+    resp->setStatusMessage("Not Found");
 
-            resp->setBody(buf.str());
-        }
-    } else if (req.method() == HttpRequest::Method::kGet &&
-               req.path().find("/login") != std::string::npos) {
-        LOG_INFO << req.path();
-        LOG_INFO << req.query();
-
-        std::regex pattern(
-            "\\?Username=([0-9a-zA-Z]+)&password=([0-9a-zA-Z]+)");
-
-        std::string query = req.query(), username, passwd;
-        for (std::sregex_iterator iter(query.begin(), query.end(), pattern),
-             iterEnd;
-             iter != iterEnd; ++iter) {
-            username = iter->str(1);
-            passwd = iter->str(2);
-        }
+    resp->setContentType("text/html");
+    resp->addHeader("Server", "Lux polaris");
 
-        //  使用 Redis 缓存
-        if (redisConn_.hasHField(HASH_KEY, username)) {
-            std::string pwd;
-            redisConn_.getHField(HASH_KEY, username, pwd);
-            LOG_INFO << "username: " << username << "pwd: " << pwd;
+    setFileBody("/404.html", req, resp);
 
-            if (pwd == passwd) {
-                resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
-                resp->setStatusMessage("OK");
-                resp->setContentType("text/html");
-                resp->addHeader("Server", "Lux polaris");
+    resp->setCloseConnection(true);
+}
 
-                strcpy(realFile_, serverPath_.c_str());
-                int len = strlen(realFile_);
-                LOG_INFO << "realFile_ len: " << len;
+namespace {
 
-                const char* index = "/welcome.html";
-                strcat(realFile_, index);
+/// @c etag of the representation, encoded bodies get their own validator.
+std::string representationEtag(const FileCache::FilePtr& file,
+                               FileCache::Encoding encoding) {
+    if (encoding == FileCache::kIdentity) return file->etag;
 
-                resp->setBody(getHtml());
-            } else {
-                resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
-                resp->setStatusMessage("OK");
-                resp->setContentType("text/html");
-                resp->addHeader("Server", "Lux polaris");
+    std::string etag(file->etag, 0, file->etag.size() - 1);
+    etag += '-';
+    etag += FileCache::encodingName(encoding);
+    etag += '"';
+    return etag;
+}
 
-                strcpy(realFile_, serverPath_.c_str());
-                int len = strlen(realFile_);
-                LOG_INFO << "realFile_ len: " << len;
+bool notModified(const HttpRequest& req, const FileCache::FilePtr& file,
+                 const std::string& etag) {
+    const std::string_view ifNoneMatch = req.getHeader("If-None-Match");
+    // If-Modified-Since is ignored when If-None-Match is present
+    if (!ifNoneMatch.empty()) return etagMatches(ifNoneMatch, etag);
+
+    const std::string_view ifModifiedSince =
+        req.getHeader("If-Modified-Since");
+    if (ifModifiedSince.empty()) return false;
+    time_t since = parseHttpDate(ifModifiedSince);
+    return since >= 0 && file->mtime <= since;
+}
 
-                const char* index = "/loginFailed.html";
-                strcat(realFile_, index);
+/// Body of a file too big for FileCache, read a piece at a time as the
+/// client takes it. Reads in the IO loop, mostly from the page cache.
+class FileStream {
+private:
+    int fd_;
+    off_t offset_;
+    const off_t size_;
+
+public:
+    FileStream(const FileStream&) = delete;
+    FileStream& operator=(const FileStream&) = delete;
+
+    FileStream(int fd, off_t size) : fd_(fd), offset_(0), size_(size) {}
+    ~FileStream() { ::close(fd_); }
+
+    bool read(Buffer* buf) {
+        size_t len = std::min(HttpResponse::kStreamPieceSize,
+                              static_cast<size_t>(size_ - offset_));
+        buf->ensureWritableBytes(len);
+        ssize_t n = ::pread(fd_, buf->beginWrite(), len, offset_);
+        if (n <= 0) {
+            // truncated meanwhile, HttpServer closes the short response
+            LOG_SYSERR << "FileStream::read";
+            return false;
+        }
+        buf->hasWritten(static_cast<size_t>(n));
+        offset_ += n;
+        return offset_ < size_;
+    }
+};
 
-                resp->setBody(getHtml());
-            }
-        } else {
-            resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
-            resp->setStatusMessage("OK");
-            resp->setContentType("text/html");
-            resp->addHeader("Server", "Lux polaris");
+}  // namespace
 
-            strcpy(realFile_, serverPath_.c_str());
-            int len = strlen(realFile_);
-            LOG_INFO << "realFile_ len: " << len;
+redis::RedisConn& Application::redisConn() {
+    if (!t_redisConn) {
+        t_redisConn.reset(new redis::RedisConn);
+        t_redisConn->connectSvr("127.0.0.1", kRedisPort, kRedisTimeoutMs);
+        LOG_INFO << "Redis connected in thread " << CurrentThread::tid();
+    }
+    return *t_redisConn;
+}
 
-            const char* index = "/loginFailed.html";
-            strcat(realFile_, index);
+AsyncRedisClient* Application::asyncRedis() { return t_asyncRedis.get(); }
 
-            resp->setBody(getHtml());
+void Application::storeCredential(EventLoop* loop, const std::string& username,
+                                  const std::string& passwd) {
+    credentials_.put(username, passwd);
+    loop->runInLoop([this, username, passwd] {
+        AsyncRedisClient* redis = asyncRedis();
+        if (redis != nullptr && redis->connected()) {
+            redis->hset(HASH_KEY, username, passwd,
+                        AsyncRedisClient::ReplyCallback());
+        } else {
+            workerPool_.run([username, passwd] {
+                redisConn().setHField(HASH_KEY, username, passwd);
+            });
         }
-    } else {
-        resp->setStatusCode(HttpResponse::HttpStatusCode::k404NotFound);
-        resp->setStatusMessage("Not Found");
+    });
+}
 
-        resp->setContentType("text/html");
-        resp->addHeader("Server", "Lux polaris");
+void Application::setFileBody(std::string_view name, const HttpRequest& req,
+                              HttpResponse* resp) {
+    // deferred handlers run outside onRequest()'s scope
+    ScratchArena::Scope scratch;
+    FileCache::FilePtr file =
+        fileCache_.get(scratch.arena().concat({serverPath_, name}));
+    if (!file) return;
+    if (file->streamed) {
+        setFileStream(file, req, resp);
+        return;
+    }
 
-        strcpy(realFile_, serverPath_.c_str());
-        int len = strlen(realFile_);
-        LOG_INFO << "realFile_ len: " << len;
+    if (file->compressible) resp->addHeader("Vary", "Accept-Encoding");
+
+    // ranges are served over the identity body
+    const std::string_view range = req.getHeader("Range");
+    FileCache::Encoding encoding = FileCache::kIdentity;
+    int accepted =
+        range.empty()
+            ? FileCache::acceptedEncodings(req.getHeader("Accept-Encoding"))
+            : FileCache::kIdentity;
+    std::shared_ptr<const std::string> body =
+        fileCache_.body(file, accepted, &encoding);
+    if (encoding != FileCache::kIdentity) {
+        resp->addHeader("Content-Encoding", FileCache::encodingName(encoding));
+    }
 
-        strcat(realFile_, "/404.html");
+    // validators only make sense for a successful GET / HEAD
+    bool cacheable = resp->statusCode() == HttpResponse::HttpStatusCode::k200Ok &&
+                     (req.method() == HttpRequest::Method::kGet ||
+                      req.method() == HttpRequest::Method::kHead);
+    if (!cacheable) {
+        resp->setBody(body);
+        return;
+    }
 
-        resp->setBody(getHtml());
+    const std::string etag = representationEtag(file, encoding);
+    resp->addHeader("ETag", etag);
+    resp->addHeader("Last-Modified", file->lastModified);
+    resp->addHeader("Accept-Ranges", "bytes");
 
-        resp->setCloseConnection(true);
+    if (notModified(req, file, etag)) {
+        resp->setStatusCode(HttpResponse::HttpStatusCode::k304NotModified);
+        resp->setStatusMessage("Not Modified");
+        return;
     }
-    // FILE REQUEST
-    return;
-}
 
-std::string readFile2String(const char* filename) {
-    std::ifstream ifs;
-    Lute::FSUtil::openForRead(ifs, filename, std::ios_base::in | std::ios_base::binary);
+    if (!range.empty() && ifRangeMatches(req.getHeader("If-Range"), etag,
+                                         file->lastModified)) {
+        size_t offset = 0, len = 0;
+        char contentRange[64];
+        switch (parseRange(range, body->size(), &offset, &len)) {
+            case RangeResult::kSatisfiable:
+                ::snprintf(contentRange, sizeof(contentRange),
+                           "bytes %zu-%zu/%zu", offset, offset + len - 1,
+                           body->size());
+                resp->setStatusCode(
+                    HttpResponse::HttpStatusCode::k206PartialContent);
+                resp->setStatusMessage("Partial Content");
+                resp->addHeader("Content-Range", contentRange);
+                resp->setBody(body, offset, len);
+                return;
+
+            case RangeResult::kUnsatisfiable:
+                ::snprintf(contentRange, sizeof(contentRange), "bytes */%zu",
+                           body->size());
+                resp->setStatusCode(
+                    HttpResponse::HttpStatusCode::k416RangeNotSatisfiable);
+                resp->setStatusMessage("Range Not Satisfiable");
+                resp->addHeader("Content-Range", contentRange);
+                return;
+
+            default:
+                break;
+        }
+    }
 
-    if (!ifs.is_open()) {
-        LOG_ERROR << "Open " << filename << " failed";
-        return "";
-    } else {
-        // 将文件读入到ostringstream对象buf中
-        std::ostringstream buf{};
-        char ch;
-        while (buf && ifs.get(ch)) buf.put(ch);
+    resp->setBody(body);
+}
 
-        return buf.str();
+void Application::setFileStream(const FileCache::FilePtr& file,
+                                const HttpRequest& req, HttpResponse* resp) {
+    if (resp->statusCode() == HttpResponse::HttpStatusCode::k200Ok &&
+        (req.method() == HttpRequest::Method::kGet ||
+         req.method() == HttpRequest::Method::kHead)) {
+        resp->addHeader("ETag", file->etag);
+        resp->addHeader("Last-Modified", file->lastModified);
+        if (notModified(req, file, file->etag)) {
+            resp->setStatusCode(HttpResponse::HttpStatusCode::k304NotModified);
+            resp->setStatusMessage("Not Modified");
+            return;
+        }
+    }
+
+    if (resp->headersOnly()) {
+        // only its length goes out, no need to open it
+        resp->setBodyStream([](Buffer*) { return false; }, file->size);
+        return;
     }
-    // int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
-    // if (fd < 0) {
-    //     LOG_ERROR << "Failed to open file " << filename;
-    //     // exit(EXIT_FAILURE);
-    // }
-
-    // struct stat statbuf;
-    // if (::fstat(fd, &statbuf) < 0) {
-    //     LOG_ERROR << "Failed to get file size";
-    //     // exit(EXIT_FAILURE);
-    // }
-
-    // char* file_contents = static_cast<char*>(
-    //     ::mmap(0, statbuf.st_size, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0));
-    // if (file_contents == MAP_FAILED) {
-    //     LOG_ERROR << "Failed to mmap file";
-    //     // exit(EXIT_FAILURE);
-    // }
-
-    // std::string str(file_contents, statbuf.st_size);
-
-    // if (::munmap(file_contents, statbuf.st_size) < 0) {
-    //     LOG_ERROR << "Failed to munmap file";
-    //     // exit(EXIT_FAILURE);
-    // }
-
-    // ::close(fd);
-
-    // return str;
-}
 
-std::string Application::getHtml() {
-    std::string ret{};
-
-    // NO resource
-    if (stat(realFile_, &fileStat_) < 0) return ret;
-    // FORBIDDEN REQUEST
-    if (!(fileStat_.st_mode & S_IROTH)) return ret;
-    // BAD_REQUEST
-    if (S_ISDIR(fileStat_.st_mode)) return ret;
-
-    // std::ifstream ifs(realFile_, std::ios::ios_base::binary);
-    // if (!ifs.is_open()) {
-    //     LOG_ERROR << "Open " << realFile_ << " failed";
-    //     return ret;
-    // } else {
-    //     // 将文件读入到ostringstream对象buf中
-    //     std::ostringstream buf{};
-    //     char ch;
-    //     while (buf && ifs.get(ch)) buf.put(ch);
-
-    //     return buf.str();
-    // }
-
-    return readFile2String(realFile_);
+    int fd = ::open(file->path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_SYSERR << "Application::setFileStream " << file->path;
+        return;
+    }
+    auto stream = std::make_shared<FileStream>(fd, file->size);
+    resp->setBodyStream([stream](Buffer* buf) { return stream->read(buf); },
+                        file->size);
 }
 
 const static std::string ICON =
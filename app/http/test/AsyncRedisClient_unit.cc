@@ -0,0 +1,175 @@
+#include <LuteBase.h>
+#include <LutePolaris.h>
+#include <http/AsyncRedisClient.h>
+
+#include <cstdio>
+#include <map>
+#include <string>
+
+using namespace Lute;
+using namespace Lute::http;
+
+#define STR(x) #x
+#define CHECK_EQUAL(x, y)                              \
+    printf("%s %s:%d %s @ %s\n",                       \
+           ((x) != (y)) ? ("[ " RED "Faild" CLR " ] ") \
+                        : ("[ " GREEN "ok" CLR " ]"),  \
+           __FILE__, __LINE__, STR(x), STR(y))
+
+using Reply = AsyncRedisClient::Reply;
+using ParseResult = AsyncRedisClient::ParseResult;
+
+/// Speaks just enough RESP for the client: PING, HSET, HGET and HEXISTS.
+class FakeRedisServer {
+private:
+    TCPServer server_;
+    std::map<std::string, std::map<std::string, std::string>> hashes_;
+
+    void onMessage(const TCPConnectionPtr& conn, Buffer* buf, Timestamp) {
+        int numCommands = 0;
+        Buffer out;
+        for (;;) {
+            Reply cmd;
+            const char* next = nullptr;
+            ParseResult result = AsyncRedisClient::parseReply(
+                buf->peek(), buf->peek() + buf->readableBytes(), &cmd, &next);
+            if (result != ParseResult::kOk) break;
+            buf->retrieveUntil(next);
+            ++numCommands;
+            execute(cmd, &out);
+        }
+        if (numCommands > maxPipelined) maxPipelined = numCommands;
+        conn->send(&out);
+    }
+
+    void execute(const Reply& cmd, Buffer* out) {
+        const std::vector<Reply>& args = cmd.elements;
+        const std::string& name = args.empty() ? "" : args[0].str;
+        if (name == "PING") {
+            out->append("+PONG\r\n");
+        } else if (name == "HSET" && args.size() == 4) {
+            bool added = hashes_[args[1].str].count(args[2].str) == 0;
+            hashes_[args[1].str][args[2].str] = args[3].str;
+            out->append(added ? ":1\r\n" : ":0\r\n");
+        } else if (name == "HGET" && args.size() == 3) {
+            auto& hash = hashes_[args[1].str];
+            auto it = hash.find(args[2].str);
+            if (it == hash.end()) {
+                out->append("$-1\r\n");
+            } else {
+                out->append("$" + std::to_string(it->second.size()) + "\r\n" +
+                            it->second + "\r\n");
+            }
+        } else if (name == "HEXISTS" && args.size() == 3) {
+            out->append(hashes_[args[1].str].count(args[2].str) ? ":1\r\n"
+                                                                : ":0\r\n");
+        } else {
+            out->append("-ERR unknown command\r\n");
+        }
+    }
+
+public:
+    int maxPipelined = 0;
+
+    FakeRedisServer(EventLoop* loop, const InetAddress& listenAddr)
+        : server_(loop, listenAddr, "FakeRedisServer") {
+        server_.setMessageCallback(
+            std::bind(&FakeRedisServer::onMessage, this, std::placeholders::_1,
+                      std::placeholders::_2, std::placeholders::_3));
+    }
+
+    void start() { server_.start(); }
+    InetAddress listenAddress() const { return server_.listenAddress(); }
+};
+
+void testParser() {
+    const std::string input = "*3\r\n$4\r\nHGET\r\n:42\r\n$-1\r\n+OK\r\n";
+    const char* next = nullptr;
+
+    // every prefix is incomplete
+    for (size_t len = 0; len < input.size() - 5; ++len) {
+        Reply reply;
+        if (AsyncRedisClient::parseReply(input.data(), input.data() + len,
+                                         &reply, &next) !=
+            ParseResult::kIncomplete) {
+            CHECK_EQUAL(len, 0xdead);
+        }
+    }
+
+    Reply reply;
+    ParseResult result = AsyncRedisClient::parseReply(
+        input.data(), input.data() + input.size(), &reply, &next);
+    CHECK_EQUAL(result, ParseResult::kOk);
+    CHECK_EQUAL(reply.type, Reply::kArray);
+    CHECK_EQUAL(reply.elements.size(), 3);
+    CHECK_EQUAL(reply.elements[0].str, "HGET");
+    CHECK_EQUAL(reply.elements[1].integer, 42);
+    CHECK_EQUAL(reply.elements[2].type, Reply::kNil);
+    CHECK_EQUAL(std::string(next), "+OK\r\n");
+
+    const std::string bad = "$3\r\nabcd\r\n";
+    result = AsyncRedisClient::parseReply(bad.data(), bad.data() + bad.size(),
+                                          &reply, &next);
+    CHECK_EQUAL(result, ParseResult::kError);
+
+    Buffer buf;
+    AsyncRedisClient::encode({"HSET", "user", "lux", ""}, &buf);
+    CHECK_EQUAL(buf.retrieveAllAsString(),
+                "*4\r\n$4\r\nHSET\r\n$4\r\nuser\r\n$3\r\nlux\r\n$0\r\n\r\n");
+}
+
+int main() {
+    testParser();
+
+    const int kNumCommands = 100;
+    EventLoop loop;
+    // any free port
+    FakeRedisServer server(&loop, InetAddress(0, true));
+    server.start();
+
+    const InetAddress addr("127.0.0.1", server.listenAddress().toPort(),
+                           false);
+    AsyncRedisClient client(&loop, addr);
+    int numReplies = 0;
+
+    // queued before the connection is up
+    client.command({"PING"}, [&](const Reply& reply) {
+        CHECK_EQUAL(reply.str, "PONG");
+    });
+
+    client.setConnectCallback([&](bool connected) {
+        if (!connected) return;
+        for (int i = 0; i < kNumCommands; ++i) {
+            client.hset("user", "name" + std::to_string(i), std::to_string(i),
+                        [&](const Reply& reply) {
+                            if (reply.type == Reply::kInteger) ++numReplies;
+                        });
+        }
+        client.hget("user", "name7", [&](const Reply& reply) {
+            CHECK_EQUAL(reply.type, Reply::kString);
+            CHECK_EQUAL(reply.str, "7");
+        });
+        client.hget("user", "nobody", [&](const Reply& reply) {
+            CHECK_EQUAL(reply.type, Reply::kNil);
+        });
+        client.command({"FLUSHALL"}, [&](const Reply& reply) {
+            CHECK_EQUAL(reply.isError(), true);
+        });
+        client.hexists("user", "name99", [&](const Reply& reply) {
+            CHECK_EQUAL(reply.integer, 1);
+            CHECK_EQUAL(numReplies, kNumCommands);
+            CHECK_EQUAL(client.outstanding(), 0);
+            // all of them were written at once
+            CHECK_EQUAL(server.maxPipelined > 1, true);
+            client.disconnect();
+            loop.runAfter(0.1, [&] { loop.quit(); });
+        });
+    });
+
+    client.connect();
+    loop.runAfter(5.0, [&] {
+        CHECK_EQUAL(std::string("timeout"), "");
+        loop.quit();
+    });
+    loop.loop();
+}
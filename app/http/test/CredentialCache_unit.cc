@@ -0,0 +1,165 @@
+#include <LuteBase.h>
+#include <http/CredentialCache.h>
+
+#include <cstdio>
+#include <functional>
+#include <string>
+
+using namespace Lute;
+using namespace Lute::http;
+
+#define STR(x) #x
+#define CHECK_EQUAL(x, y)                              \
+    printf("%s %s:%d %s @ %s\n",                       \
+           ((x) != (y)) ? ("[ " RED "Faild" CLR " ] ") \
+                        : ("[ " GREEN "ok" CLR " ]"),  \
+           __FILE__, __LINE__, STR(x), STR(y))
+
+using Lookup = CredentialCache::Lookup;
+
+// what CredentialCache sees as now, moved by hand
+static Timestamp fakeNow = Timestamp::now();
+
+static Timestamp fakeClock() { return fakeNow; }
+
+static void advance(double seconds) { fakeNow = addTime(fakeNow, seconds); }
+
+/// The @c nth user name of the shard of "user0".
+static std::string sameShard(int nth) {
+    const size_t shard =
+        std::hash<std::string>()("user0") % CredentialCache::kNumShards;
+    for (int i = 0;; ++i) {
+        std::string name = "user" + std::to_string(i);
+        if (std::hash<std::string>()(name) % CredentialCache::kNumShards ==
+                shard &&
+            nth-- == 0)
+            return name;
+    }
+}
+
+void testFind() {
+    CredentialCache cache(60, 60);
+    std::string passwd = "untouched";
+    CHECK_EQUAL(cache.find("lux", &passwd) == Lookup::kMiss, true);
+    CHECK_EQUAL(passwd, "untouched");
+
+    cache.put("lux", "secret");
+    cache.putAbsent("nobody");
+    CHECK_EQUAL(cache.size(), 2u);
+    CHECK_EQUAL(cache.find("lux", &passwd) == Lookup::kFound, true);
+    CHECK_EQUAL(passwd, "secret");
+    passwd = "untouched";
+    CHECK_EQUAL(cache.find("nobody", &passwd) == Lookup::kAbsent, true);
+    CHECK_EQUAL(passwd, "untouched");
+
+    // a registration replaces the negative entry, a change the password
+    cache.put("nobody", "new");
+    cache.put("lux", "changed");
+    CHECK_EQUAL(cache.size(), 2u);
+    CHECK_EQUAL(cache.find("nobody", &passwd) == Lookup::kFound, true);
+    CHECK_EQUAL(passwd, "new");
+    CHECK_EQUAL(cache.find("lux", &passwd) == Lookup::kFound, true);
+    CHECK_EQUAL(passwd, "changed");
+
+    cache.erase("lux");
+    cache.erase("missing");
+    CHECK_EQUAL(cache.find("lux", &passwd) == Lookup::kMiss, true);
+    CHECK_EQUAL(cache.size(), 1u);
+}
+
+void testTtl() {
+    CredentialCache cache(60, 10);
+    cache.setClock(fakeClock);
+    std::string passwd;
+    cache.put("lux", "secret");
+    cache.putAbsent("nobody");
+
+    // valid up to its expiration included
+    advance(10);
+    CHECK_EQUAL(cache.find("nobody", &passwd) == Lookup::kAbsent, true);
+    // the negative entry goes first, and is dropped on lookup
+    advance(0.001);
+    CHECK_EQUAL(cache.find("nobody", &passwd) == Lookup::kMiss, true);
+    CHECK_EQUAL(cache.size(), 1u);
+    CHECK_EQUAL(cache.find("lux", &passwd) == Lookup::kFound, true);
+
+    // a put starts the TTL over
+    cache.put("lux", "secret");
+    advance(59);
+    CHECK_EQUAL(cache.find("lux", &passwd) == Lookup::kFound, true);
+    advance(2);
+    CHECK_EQUAL(cache.find("lux", &passwd) == Lookup::kMiss, true);
+    CHECK_EQUAL(cache.size(), 0u);
+
+    // a negative entry put again is kept for the negative TTL, not the TTL
+    cache.put("gone", "secret");
+    cache.putAbsent("gone");
+    advance(11);
+    CHECK_EQUAL(cache.find("gone", &passwd) == Lookup::kMiss, true);
+    // and a known user again for the TTL
+    cache.putAbsent("back");
+    cache.put("back", "secret");
+    advance(30);
+    CHECK_EQUAL(cache.find("back", &passwd) == Lookup::kFound, true);
+}
+
+void testBounded() {
+    const size_t kMax = 2;
+    CredentialCache cache(60, 10, kMax);
+    for (int i = 0; i < 200; ++i) {
+        cache.put("user" + std::to_string(i), "x");
+    }
+    CHECK_EQUAL(cache.size() <= kMax * CredentialCache::kNumShards, true);
+    CHECK_EQUAL(cache.size() > 0u, true);
+
+    // updating an entry of a full shard evicts nothing
+    const size_t full = cache.size();
+    std::string passwd;
+    CHECK_EQUAL(cache.find("user199", &passwd) == Lookup::kFound, true);
+    cache.put("user199", "y");
+    CHECK_EQUAL(cache.size(), full);
+    CHECK_EQUAL(cache.find("user199", &passwd) == Lookup::kFound, true);
+    CHECK_EQUAL(passwd, "y");
+
+    // expired entries make room before live ones are dropped
+    CredentialCache shard(60, 10, kMax);
+    shard.setClock(fakeClock);
+    const std::string names[3] = {sameShard(0), sameShard(1), sameShard(2)};
+    shard.put(names[0], "x");
+    shard.putAbsent(names[1]);
+    advance(20);
+    shard.put(names[2], "x");
+    CHECK_EQUAL(shard.size(), 2u);
+    CHECK_EQUAL(shard.find(names[0], &passwd) == Lookup::kFound, true);
+    CHECK_EQUAL(shard.find(names[2], &passwd) == Lookup::kFound, true);
+
+    // then the oldest unknown user, then the oldest known one
+    CredentialCache order(60, 60, kMax);
+    order.put(names[0], "x");
+    order.putAbsent(names[1]);
+    order.put(names[2], "x");
+    CHECK_EQUAL(order.find(names[1], &passwd) == Lookup::kMiss, true);
+    CHECK_EQUAL(order.find(names[0], &passwd) == Lookup::kFound, true);
+    order.put(sameShard(3), "x");
+    CHECK_EQUAL(order.find(names[0], &passwd) == Lookup::kMiss, true);
+    CHECK_EQUAL(order.find(names[2], &passwd) == Lookup::kFound, true);
+    // a put again is the newest
+    order.put(names[2], "y");
+    order.put(sameShard(4), "x");
+    CHECK_EQUAL(order.find(names[2], &passwd) == Lookup::kFound, true);
+    CHECK_EQUAL(order.find(sameShard(3), &passwd) == Lookup::kMiss, true);
+
+    // tryPut() refuses instead of evicting, but updates in place
+    CHECK_EQUAL(order.tryPut(sameShard(5), "x"), false);
+    CHECK_EQUAL(order.find(sameShard(5), &passwd) == Lookup::kMiss, true);
+    CHECK_EQUAL(order.tryPut(names[2], "z"), true);
+    CHECK_EQUAL(order.find(names[2], &passwd) == Lookup::kFound, true);
+    CHECK_EQUAL(passwd, "z");
+    CHECK_EQUAL(order.size(), 2u);
+}
+
+int main() {
+    testFind();
+    testTtl();
+    testBounded();
+}
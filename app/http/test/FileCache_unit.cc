@@ -0,0 +1,217 @@
+#include <LuteBase.h>
+#include <http/FileCache.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace Lute;
+using namespace Lute::http;
+
+#define STR(x) #x
+#define CHECK_EQUAL(x, y)                              \
+    printf("%s %s:%d %s @ %s\n",                       \
+           ((x) != (y)) ? ("[ " RED "Faild" CLR " ] ") \
+                        : ("[ " GREEN "ok" CLR " ]"),  \
+           __FILE__, __LINE__, STR(x), STR(y))
+
+// files of a test, removed by main()
+static std::string dir;
+
+static std::string writeFile(const std::string& name, size_t size,
+                             char c = 'x') {
+    const std::string path = dir + "/" + name;
+    FILE* fp = ::fopen(path.c_str(), "w");
+    const std::string content(size, c);
+    ::fwrite(content.data(), 1, content.size(), fp);
+    ::fclose(fp);
+    return path;
+}
+
+void testLoad() {
+    FileCache cache(8000);
+    const std::string path = writeFile("index.html", 100);
+    FileCache::FilePtr file = cache.get(path);
+    CHECK_EQUAL(file != nullptr, true);
+    CHECK_EQUAL(file->content, std::string(100, 'x'));
+    CHECK_EQUAL(file->contentType, "text/html");
+    CHECK_EQUAL(file->streamed, false);
+    CHECK_EQUAL(cache.size(), 1u);
+    CHECK_EQUAL(cache.bytes(), 100u);
+    // a hit is the same entry
+    CHECK_EQUAL(cache.get(path) == file, true);
+
+    CHECK_EQUAL(cache.get(dir + "/missing.html") == nullptr, true);
+    CHECK_EQUAL(cache.get(dir) == nullptr, true);
+    CHECK_EQUAL(cache.size(), 1u);
+
+    // over capacity / 8, streamed from disk and never cached
+    const std::string big = writeFile("big.bin", 1001);
+    FileCache::FilePtr streamed = cache.get(big);
+    CHECK_EQUAL(streamed != nullptr, true);
+    CHECK_EQUAL(streamed->streamed, true);
+    CHECK_EQUAL(streamed->content.empty(), true);
+    CHECK_EQUAL(streamed->size, 1001);
+    CHECK_EQUAL(cache.size(), 1u);
+}
+
+void testLru() {
+    // 8 files of 1000 bytes fit, the 9th evicts
+    FileCache cache(8000);
+    std::string paths[10];
+    for (int i = 0; i < 10; ++i) {
+        paths[i] = writeFile("f" + std::to_string(i) + ".bin", 1000);
+    }
+    for (int i = 0; i < 8; ++i) cache.get(paths[i]);
+    CHECK_EQUAL(cache.size(), 8u);
+    CHECK_EQUAL(cache.bytes(), 8000u);
+
+    // f0 becomes the most recently used, f1 the least
+    FileCache::FilePtr f0 = cache.get(paths[0]);
+    cache.get(paths[8]);
+    CHECK_EQUAL(cache.size(), 8u);
+    CHECK_EQUAL(cache.bytes(), 8000u);
+    CHECK_EQUAL(cache.get(paths[0]) == f0, true);
+
+    // f1 was evicted: loaded again, which evicts f2
+    FileCache::FilePtr f2 = cache.get(paths[2]);
+    cache.get(paths[9]);
+    FileCache::FilePtr f1 = cache.get(paths[1]);
+    CHECK_EQUAL(cache.size(), 8u);
+    CHECK_EQUAL(cache.get(paths[1]) == f1, true);
+    // f3 went for f9, then f4 for f1
+    CHECK_EQUAL(cache.get(paths[2]) == f2, true);
+    CHECK_EQUAL(cache.bytes(), 8000u);
+}
+
+void testRevalidate() {
+    FileCache cache(8000);
+    const std::string a = writeFile("a.txt", 100);
+    const std::string b = writeFile("b.txt", 100);
+    FileCache::FilePtr fa = cache.get(a);
+    FileCache::FilePtr fb = cache.get(b);
+
+    cache.revalidate();
+    CHECK_EQUAL(cache.size(), 2u);
+
+    writeFile("a.txt", 200, 'y');
+    ::unlink(b.c_str());
+    cache.revalidate();
+    CHECK_EQUAL(cache.size(), 0u);
+    CHECK_EQUAL(cache.bytes(), 0u);
+    // entries handed out stay valid
+    CHECK_EQUAL(fa->content, std::string(100, 'x'));
+
+    FileCache::FilePtr reloaded = cache.get(a);
+    CHECK_EQUAL(reloaded->content, std::string(200, 'y'));
+    CHECK_EQUAL(reloaded->etag != fa->etag, true);
+}
+
+void testAcceptedEncodings() {
+    const int kBoth = FileCache::kGzip | FileCache::kDeflate;
+#ifdef LUTE_HAVE_ZLIB
+    CHECK_EQUAL(FileCache::acceptedEncodings("gzip"), FileCache::kGzip);
+    CHECK_EQUAL(FileCache::acceptedEncodings("gzip, deflate, br"), kBoth);
+    CHECK_EQUAL(FileCache::acceptedEncodings("GZip,DEFLATE"), kBoth);
+    CHECK_EQUAL(FileCache::acceptedEncodings("deflate;q=0.5"),
+                FileCache::kDeflate);
+    CHECK_EQUAL(FileCache::acceptedEncodings("*"), kBoth);
+    // q=0 means not acceptable
+    CHECK_EQUAL(FileCache::acceptedEncodings("gzip;q=0, deflate"),
+                FileCache::kDeflate);
+    CHECK_EQUAL(FileCache::acceptedEncodings("gzip;q=0.000,deflate;q=0"),
+                FileCache::kIdentity);
+    CHECK_EQUAL(FileCache::acceptedEncodings("gzip ; q=0"),
+                FileCache::kIdentity);
+    CHECK_EQUAL(FileCache::acceptedEncodings("*;q=0"), FileCache::kIdentity);
+    CHECK_EQUAL(FileCache::acceptedEncodings("gzip;q=0.001"),
+                FileCache::kGzip);
+    CHECK_EQUAL(FileCache::acceptedEncodings("gzip;q=1.0, deflate;q=0.9"),
+                kBoth);
+#endif
+    // nothing we can encode
+    CHECK_EQUAL(FileCache::acceptedEncodings(""), FileCache::kIdentity);
+    CHECK_EQUAL(FileCache::acceptedEncodings("br, x-gzip, identity"),
+                FileCache::kIdentity);
+    (void)kBoth;
+}
+
+void testBody() {
+    ThreadPool pool("FileCacheCompress");
+    pool.start(1);
+    FileCache cache(8000);
+    cache.setCompressPool(&pool);
+    const std::string path = writeFile("page.html", 1000);
+    FileCache::FilePtr file = cache.get(path);
+    CHECK_EQUAL(file->compressible, true);
+
+    FileCache::Encoding encoding = FileCache::kGzip;
+    auto body = cache.body(file, FileCache::kIdentity, &encoding);
+    CHECK_EQUAL(encoding, FileCache::kIdentity);
+    // shares the entry, no copy
+    CHECK_EQUAL(body->data(), file->content.data());
+
+#ifdef LUTE_HAVE_ZLIB
+    // built by the pool after the first get(), then counted against the
+    // capacity
+    for (int i = 0; i < 200 && cache.bytes() == file->content.size(); ++i) {
+        ::usleep(10 * 1000);
+    }
+    CHECK_EQUAL(cache.bytes() > file->content.size(), true);
+    body = cache.body(file, FileCache::kGzip | FileCache::kDeflate,
+                      &encoding);
+    CHECK_EQUAL(encoding, FileCache::kGzip);
+    CHECK_EQUAL(body->size() < file->content.size(), true);
+    cache.body(file, FileCache::kDeflate, &encoding);
+    CHECK_EQUAL(encoding, FileCache::kDeflate);
+    cache.body(file, FileCache::kIdentity, &encoding);
+    CHECK_EQUAL(encoding, FileCache::kIdentity);
+#endif
+    pool.stop();
+}
+
+void testAccounting() {
+#ifdef LUTE_HAVE_ZLIB
+    // variants land while entries are evicted and invalidated
+    ThreadPool pool("FileCacheCompress");
+    pool.start(2);
+    FileCache cache(64 * 1024);
+    cache.setCompressPool(&pool);
+    std::string paths[32];
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 32; ++i) {
+            // a new size is stale even within the same mtime second
+            paths[i] = writeFile("acc" + std::to_string(i) + ".html",
+                                 1000 + static_cast<size_t>(round * 32 + i),
+                                 static_cast<char>('a' + round));
+            cache.get(paths[i]);
+        }
+        cache.revalidate();
+    }
+    pool.stop();
+    CHECK_EQUAL(cache.bytes() <= 64 * 1024, true);
+
+    for (const std::string& path : paths) ::unlink(path.c_str());
+    cache.revalidate();
+    CHECK_EQUAL(cache.size(), 0u);
+    CHECK_EQUAL(cache.bytes(), 0u);
+#endif
+}
+
+int main() {
+    char tmpl[] = "/tmp/FileCache_unit.XXXXXX";
+    if (::mkdtemp(tmpl) == nullptr) return 1;
+    dir = tmpl;
+
+    testLoad();
+    testLru();
+    testRevalidate();
+    testAcceptedEncodings();
+    testBody();
+    testAccounting();
+
+    const std::string rm = "rm -rf " + dir;
+    return ::system(rm.c_str()) == 0 ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+#include <LuteBase.h>
+#include <http/FormParams.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace Lute;
+using namespace Lute::http;
+
+#define STR(x) #x
+#define CHECK_EQUAL(x, y)                              \
+    printf("%s %s:%d %s @ %s\n",                       \
+           ((x) != (y)) ? ("[ " RED "Faild" CLR " ] ") \
+                        : ("[ " GREEN "ok" CLR " ]"),  \
+           __FILE__, __LINE__, STR(x), STR(y))
+
+static bool parse(FormParams* params, const std::string& input) {
+    return params->parse(input.data(), input.data() + input.size());
+}
+
+/// FormParams::decode() of a copy of @c input.
+static std::string decode(std::string input) {
+    char* begin = &input[0];
+    input.resize(FormParams::decode(begin, begin + input.size()));
+    return input;
+}
+
+void testDecode() {
+    CHECK_EQUAL(decode("a%20b+c"), "a b c");
+    CHECK_EQUAL(decode("%41%42c"), "ABc");
+    CHECK_EQUAL(decode("%e4%BD%a0"), "\xe4\xbd\xa0");
+    CHECK_EQUAL(decode("+%2B"), " +");
+    // malformed escapes are kept as is
+    CHECK_EQUAL(decode("%zz"), "%zz");
+    CHECK_EQUAL(decode("%4z%41"), "%4zA");
+    CHECK_EQUAL(decode("%%41"), "%A");
+    CHECK_EQUAL(decode("100%"), "100%");
+    CHECK_EQUAL(decode("%4"), "%4");
+    CHECK_EQUAL(decode(""), "");
+}
+
+void testParse() {
+    FormParams params;
+    CHECK_EQUAL(parse(&params, "?user=lux&passwd=a%20b+c"), true);
+    CHECK_EQUAL(params.size(), 2);
+    CHECK_EQUAL(params.key(0), "user");
+    CHECK_EQUAL(params.get("user"), "lux");
+    CHECK_EQUAL(params.get("passwd"), "a b c");
+    CHECK_EQUAL(params.has("missing"), false);
+    CHECK_EQUAL(params.get("missing").empty(), true);
+
+    // delimiters are split before decoding
+    CHECK_EQUAL(parse(&params, "a=x%26y%3Dz&b%3D=2"), true);
+    CHECK_EQUAL(params.get("a"), "x&y=z");
+    CHECK_EQUAL(params.get("b="), "2");
+
+    // empty fields are skipped, a bare key has an empty value
+    CHECK_EQUAL(parse(&params, "&&flag&k=&=v&"), true);
+    CHECK_EQUAL(params.size(), 3);
+    CHECK_EQUAL(params.has("flag"), true);
+    CHECK_EQUAL(params.get("flag"), "");
+    CHECK_EQUAL(params.has("k"), true);
+    CHECK_EQUAL(params.key(2), "");
+    CHECK_EQUAL(params.value(2), "v");
+
+    // the first of repeated keys
+    CHECK_EQUAL(parse(&params, "k=1&k=2"), true);
+    CHECK_EQUAL(params.get("k"), "1");
+    CHECK_EQUAL(params.value(1), "2");
+
+    // parse() starts over
+    CHECK_EQUAL(parse(&params, ""), true);
+    CHECK_EQUAL(params.empty(), true);
+    CHECK_EQUAL(parse(&params, "?"), true);
+    CHECK_EQUAL(params.empty(), true);
+}
+
+void testMaxFields() {
+    FormParams params;
+    std::string input;
+    for (int i = 0; i < FormParams::kMaxFields; ++i) {
+        input += "k" + std::to_string(i) + "=" + std::to_string(i) + "&";
+    }
+    CHECK_EQUAL(parse(&params, input), true);
+    CHECK_EQUAL(params.size(), FormParams::kMaxFields);
+
+    // one more is refused, the first kMaxFields are kept
+    CHECK_EQUAL(parse(&params, input + "extra=1"), false);
+    CHECK_EQUAL(params.size(), FormParams::kMaxFields);
+    CHECK_EQUAL(params.get("k31"), "31");
+    CHECK_EQUAL(params.has("extra"), false);
+    // empty fields do not count
+    CHECK_EQUAL(parse(&params, input + "&&&"), true);
+}
+
+void testCopy() {
+    std::pmr::monotonic_buffer_resource arena;
+    FormParams params;
+    parse(&params, "a=1&b=%32");
+    FormParams copy(params, &arena);
+    params.clear();
+    CHECK_EQUAL(copy.size(), 2);
+    CHECK_EQUAL(copy.get("b"), "2");
+
+    // only between the same allocator
+    FormParams other(&arena);
+    other.swap(copy);
+    CHECK_EQUAL(copy.empty(), true);
+    CHECK_EQUAL(other.get("a"), "1");
+}
+
+int main() {
+    testDecode();
+    testParse();
+    testMaxFields();
+    testCopy();
+}
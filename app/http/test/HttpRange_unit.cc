@@ -0,0 +1,131 @@
+#include <LuteBase.h>
+#include <http/HttpRange.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+using namespace Lute;
+using namespace Lute::http;
+
+#define STR(x) #x
+#define CHECK_EQUAL(x, y)                              \
+    printf("%s %s:%d %s @ %s\n",                       \
+           ((x) != (y)) ? ("[ " RED "Faild" CLR " ] ") \
+                        : ("[ " GREEN "ok" CLR " ]"),  \
+           __FILE__, __LINE__, STR(x), STR(y))
+
+// "offset+len" of a satisfiable range, "none" or "unsatisfiable" otherwise
+static std::string range(const char* header, size_t size) {
+    size_t offset = SIZE_MAX, len = SIZE_MAX;
+    switch (parseRange(header, size, &offset, &len)) {
+        case RangeResult::kSatisfiable:
+            return std::to_string(offset) + "+" + std::to_string(len);
+        case RangeResult::kUnsatisfiable:
+            return "unsatisfiable";
+        default:
+            return "none";
+    }
+}
+
+void testRange() {
+    CHECK_EQUAL(range("bytes=0-499", 1000), "0+500");
+    CHECK_EQUAL(range("bytes=500-999", 1000), "500+500");
+    CHECK_EQUAL(range("bytes=0-0", 1000), "0+1");
+    // the end is clamped to the body
+    CHECK_EQUAL(range("bytes=500-5000", 1000), "500+500");
+    // open-ended
+    CHECK_EQUAL(range("bytes=500-", 1000), "500+500");
+    CHECK_EQUAL(range("bytes=999-", 1000), "999+1");
+    CHECK_EQUAL(range("bytes=1000-", 1000), "unsatisfiable");
+    CHECK_EQUAL(range("bytes=0-", 0), "unsatisfiable");
+}
+
+void testSuffix() {
+    CHECK_EQUAL(range("bytes=-500", 1000), "500+500");
+    CHECK_EQUAL(range("bytes=-1", 1000), "999+1");
+    // longer than the body, all of it
+    CHECK_EQUAL(range("bytes=-5000", 1000), "0+1000");
+    // nothing of it
+    CHECK_EQUAL(range("bytes=-0", 1000), "unsatisfiable");
+    CHECK_EQUAL(range("bytes=-10", 0), "unsatisfiable");
+}
+
+void testOverflow() {
+    // saturates instead of wrapping around
+    CHECK_EQUAL(range("bytes=99999999999999999999999-", 1000),
+                "unsatisfiable");
+    CHECK_EQUAL(range("bytes=18446744073709551616-", 1000), "unsatisfiable");
+    CHECK_EQUAL(range("bytes=-99999999999999999999999", 1000), "0+1000");
+    CHECK_EQUAL(range("bytes=10-99999999999999999999999", 1000), "10+990");
+}
+
+void testInvalid() {
+    // multiple ranges are not supported, the full body goes out
+    CHECK_EQUAL(range("bytes=0-1,5-6", 1000), "none");
+    CHECK_EQUAL(range("bytes=0-1, -5", 1000), "none");
+    CHECK_EQUAL(range("bytes=500-499", 1000), "none");
+    CHECK_EQUAL(range("bytes=-", 1000), "none");
+    CHECK_EQUAL(range("bytes=", 1000), "none");
+    CHECK_EQUAL(range("bytes=10", 1000), "none");
+    CHECK_EQUAL(range("bytes=a-b", 1000), "none");
+    CHECK_EQUAL(range("bytes= 0-1", 1000), "none");
+    CHECK_EQUAL(range("bytes=+1-2", 1000), "none");
+    CHECK_EQUAL(range("bytes=1--2", 1000), "none");
+    CHECK_EQUAL(range("items=0-1", 1000), "none");
+    CHECK_EQUAL(range("", 1000), "none");
+}
+
+void testEtagMatches() {
+    const std::string etag = "\"5f-1a\"";
+    CHECK_EQUAL(etagMatches("\"5f-1a\"", etag), true);
+    CHECK_EQUAL(etagMatches("*", etag), true);
+    CHECK_EQUAL(etagMatches(" * ", etag), true);
+    // weak comparison
+    CHECK_EQUAL(etagMatches("W/\"5f-1a\"", etag), true);
+    CHECK_EQUAL(etagMatches("\"5f-1a\"", "W/\"5f-1a\""), true);
+    // lists
+    CHECK_EQUAL(etagMatches("\"a\", \"5f-1a\"", etag), true);
+    CHECK_EQUAL(etagMatches("\"a\",W/\"5f-1a\" ,\"b\"", etag), true);
+    CHECK_EQUAL(etagMatches("\"a\",\t\"5f-1a\"", etag), true);
+    CHECK_EQUAL(etagMatches("\"a\", \"b\"", etag), false);
+    // a member as a whole, not a part of one
+    CHECK_EQUAL(etagMatches("\"5f-1a-gzip\"", etag), false);
+    CHECK_EQUAL(etagMatches("\"x5f-1a\"", etag), false);
+    CHECK_EQUAL(etagMatches("5f-1a", etag), false);
+    CHECK_EQUAL(etagMatches("", etag), false);
+    CHECK_EQUAL(etagMatches(",,", etag), false);
+}
+
+void testIfRange() {
+    const std::string etag = "\"5f-1a\"";
+    const std::string date = "Sun, 06 Nov 1994 08:49:37 GMT";
+    CHECK_EQUAL(ifRangeMatches("", etag, date), true);
+    CHECK_EQUAL(ifRangeMatches(etag, etag, date), true);
+    CHECK_EQUAL(ifRangeMatches(date, etag, date), true);
+    CHECK_EQUAL(ifRangeMatches("\"other\"", etag, date), false);
+    CHECK_EQUAL(ifRangeMatches("Mon, 07 Nov 1994 08:49:37 GMT", etag, date),
+                false);
+    // strong comparison only
+    CHECK_EQUAL(ifRangeMatches("W/\"5f-1a\"", etag, date), false);
+    CHECK_EQUAL(ifRangeMatches("W/\"5f-1a\"", "W/\"5f-1a\"", date), false);
+}
+
+void testHttpDate() {
+    CHECK_EQUAL(parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT"), 784111777);
+    CHECK_EQUAL(parseHttpDate("Thu, 01 Jan 1970 00:00:00 GMT"), 0);
+    CHECK_EQUAL(parseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT"), -1);
+    CHECK_EQUAL(parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT junk"), -1);
+    CHECK_EQUAL(parseHttpDate(""), -1);
+    CHECK_EQUAL(parseHttpDate(std::string(100, 'x')), -1);
+}
+
+int main() {
+    testRange();
+    testSuffix();
+    testOverflow();
+    testInvalid();
+    testEtagMatches();
+    testIfRange();
+    testHttpDate();
+}
@@ -0,0 +1,122 @@
+#include <LuteBase.h>
+#include <LutePolaris.h>
+#include <http/HttpContext.h>
+#include <http/HttpResponse.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace Lute;
+using namespace Lute::http;
+
+// every heap allocation of the process goes through here
+static size_t g_numAllocs = 0;
+
+void* operator new(size_t size) {
+    ++g_numAllocs;
+    void* p = ::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { ::free(p); }
+void operator delete(void* p, size_t) noexcept { ::free(p); }
+
+// std::pmr::new_delete_resource() asks for aligned storage
+void* operator new(size_t size, std::align_val_t align) {
+    ++g_numAllocs;
+    void* p = ::aligned_alloc(static_cast<size_t>(align),
+                              (size + static_cast<size_t>(align) - 1) &
+                                  ~(static_cast<size_t>(align) - 1));
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p, std::align_val_t) noexcept { ::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    ::free(p);
+}
+
+static const char kRequest[] =
+    "GET /index.html?lang=en&theme=dark HTTP/1.1\r\n"
+    "Host: 192.168.132.128:8000\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 "
+    "(KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,"
+    "image/avif,image/webp,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "If-None-Match: \"5f3a-65a1b2c3\"\r\n"
+    "\r\n";
+
+/// The handler of the app, roughly: status, a few headers and a body.
+void respond(const HttpRequest& req, HttpResponse* resp) {
+    resp->setStatusCode(HttpResponse::HttpStatusCode::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setContentType("text/html");
+    resp->addHeader("Server", "Lux polaris");
+    resp->addHeader("Vary", "Accept-Encoding");
+    resp->addHeader("ETag", "\"5f3a-65a1b2c3-gzip\"");
+    resp->addHeader("Last-Modified", "Sun, 06 Nov 1994 08:49:37 GMT");
+    resp->addHeader("Accept-Ranges", "bytes");
+    resp->setBody(req.path());
+}
+
+int main(int argc, char* argv[]) {
+    const int kRequests = argc > 1 ? atoi(argv[1]) : 100000;
+
+    HttpContext context;
+    Buffer input;
+    Buffer output;
+    // warm up, buffers reach their final capacity
+    input.append(kRequest, sizeof(kRequest) - 1);
+    context.parseRequest(&input, Timestamp::now());
+    context.reset();
+
+    // arena: what HttpServer does per request
+    size_t before = g_numAllocs;
+    Timestamp start = Timestamp::now();
+    for (int i = 0; i < kRequests; ++i) {
+        input.append(kRequest, sizeof(kRequest) - 1);
+        context.parseRequest(&input, Timestamp::now());
+        {
+            HttpResponse resp(false, context.allocator());
+            respond(context.request(), &resp);
+            resp.appendToBuffer(&output);
+            output.retrieveAll();
+        }
+        context.reset();
+    }
+    double arenaSeconds = timeDifference(Timestamp::now(), start);
+    size_t arenaAllocs = g_numAllocs - before;
+
+    // heap: the same request and response on the default resource, as
+    // before the arena and as deferred requests still are
+    before = g_numAllocs;
+    start = Timestamp::now();
+    for (int i = 0; i < kRequests; ++i) {
+        input.append(kRequest, sizeof(kRequest) - 1);
+        context.parseRequest(&input, Timestamp::now());
+        {
+            HttpRequest req(context.request(), HttpRequest::allocator_type());
+            HttpResponse resp(false);
+            respond(req, &resp);
+            Buffer buf;
+            resp.appendToBuffer(&buf);
+        }
+        context.reset();
+    }
+    double heapSeconds = timeDifference(Timestamp::now(), start);
+    // the arena part of the loop allocates nothing, see above
+    size_t heapAllocs = g_numAllocs - before;
+
+    printf("%d requests\n", kRequests);
+    printf("arena: %.2f allocations/request, %.0f ns/request\n",
+           static_cast<double>(arenaAllocs) / kRequests,
+           arenaSeconds * 1e9 / kRequests);
+    printf("heap:  %.2f allocations/request, %.0f ns/request\n",
+           static_cast<double>(heapAllocs) / kRequests,
+           heapSeconds * 1e9 / kRequests);
+}
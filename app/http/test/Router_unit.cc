@@ -0,0 +1,176 @@
+#include <LuteBase.h>
+#include <http/HttpRequest.h>
+#include <http/HttpResponse.h>
+#include <http/Router.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace Lute;
+using namespace Lute::http;
+
+#define STR(x) #x
+#define CHECK_EQUAL(x, y)                              \
+    printf("%s %s:%d %s @ %s\n",                       \
+           ((x) != (y)) ? ("[ " RED "Faild" CLR " ] ") \
+                        : ("[ " GREEN "ok" CLR " ]"),  \
+           __FILE__, __LINE__, STR(x), STR(y))
+
+using Method = HttpRequest::Method;
+
+// what the last routed request hit, and its parameters
+static std::string matched;
+
+static Router::Handler handler(const std::string& name) {
+    return [name](const HttpRequest&, const Router::Params& params,
+                  HttpResponse*) {
+        matched = name;
+        for (const char* param : {"id", "x", "post", "path"}) {
+            std::string_view value = params.get(param);
+            if (!value.empty()) {
+                matched += " ";
+                matched += param;
+                matched += "=";
+                matched += value;
+            }
+        }
+    };
+}
+
+/// The handler @c path is routed to for @c method, "" if none.
+static std::string route(const Router& router, const char* method,
+                         const char* path) {
+    HttpRequest req;
+    req.setMethod(method, method + ::strlen(method));
+    req.setPath(path, path + ::strlen(path));
+    HttpResponse resp(false);
+    matched.clear();
+    router.route(req, &resp);
+    return matched;
+}
+
+void testExact() {
+    Router router;
+    router.add(Method::kGet, "/", handler("root"));
+    router.add(Method::kGet, "/register", handler("get register"));
+    router.add(Method::kPost, "/register", handler("post register"));
+
+    CHECK_EQUAL(route(router, "GET", "/"), "root");
+    CHECK_EQUAL(route(router, "GET", "/register"), "get register");
+    CHECK_EQUAL(route(router, "POST", "/register"), "post register");
+    CHECK_EQUAL(route(router, "DELETE", "/register"), "");
+    // no prefix match
+    CHECK_EQUAL(route(router, "GET", "/register/"), "");
+    CHECK_EQUAL(route(router, "GET", "/registe"), "");
+}
+
+void testParams() {
+    Router router;
+    router.add(Method::kGet, "/user/:id", handler("user"));
+    router.add(Method::kGet, "/user/:id/posts/:post", handler("post"));
+    router.add(Method::kGet, "/user/me", handler("me"));
+
+    CHECK_EQUAL(route(router, "GET", "/user/42"), "user id=42");
+    CHECK_EQUAL(route(router, "GET", "/user/42/posts/7"),
+                "post id=42 post=7");
+    // static segments win over ":param"
+    CHECK_EQUAL(route(router, "GET", "/user/me"), "me");
+    // ":param" never matches an empty segment
+    CHECK_EQUAL(route(router, "GET", "/user/"), "");
+    CHECK_EQUAL(route(router, "GET", "/user//posts/7"), "");
+    CHECK_EQUAL(route(router, "GET", "/user/42/posts"), "");
+}
+
+void testBacktracking() {
+    Router router;
+    router.add(Method::kGet, "/a/b/:x", handler("b"));
+    router.add(Method::kGet, "/a/:id/d/e", handler("de"));
+    router.add(Method::kGet, "/a/*path", handler("rest"));
+
+    CHECK_EQUAL(route(router, "GET", "/a/b/d"), "b x=d");
+    // "b" is tried statically first, then as ":id", without the ":x"
+    // pushed on the way
+    CHECK_EQUAL(route(router, "GET", "/a/b/d/e"), "de id=b");
+    // both fail, the wildcard takes the rest, without any of them
+    CHECK_EQUAL(route(router, "GET", "/a/b/d/f"), "rest path=b/d/f");
+    CHECK_EQUAL(route(router, "GET", "/a/c/d/e"), "de id=c");
+    // a method only one branch has sends the others on
+    router.add(Method::kPost, "/a/:id/d/e", handler("post de"));
+    CHECK_EQUAL(route(router, "POST", "/a/b/d/e"), "post de id=b");
+    CHECK_EQUAL(route(router, "POST", "/a/b/d"), "");
+}
+
+void testWildcard() {
+    Router router;
+    router.add(Method::kGet, "/static/*path", handler("static"));
+
+    CHECK_EQUAL(route(router, "GET", "/static/css/site.css"),
+                "static path=css/site.css");
+    // empty rest, and empty segments inside it, are kept as they are
+    CHECK_EQUAL(route(router, "GET", "/static/"), "static");
+    CHECK_EQUAL(route(router, "GET", "/static//a"), "static path=/a");
+    CHECK_EQUAL(route(router, "GET", "/static"), "");
+}
+
+void testExtensions() {
+    Router router;
+    router.add(Method::kGet, "/img/logo.png", handler("logo"));
+    router.addExtension(Method::kGet, ".png", handler("png"));
+    router.addExtension(Method::kGet, ".jpg", handler("jpg"));
+    // replaces, not added twice
+    router.addExtension(Method::kGet, ".jpg", handler("jpeg"));
+
+    // exact paths first
+    CHECK_EQUAL(route(router, "GET", "/img/logo.png"), "logo");
+    CHECK_EQUAL(route(router, "GET", "/img/other.png"), "png");
+    CHECK_EQUAL(route(router, "GET", "/a/b/c.jpg"), "jpeg");
+    CHECK_EQUAL(route(router, "GET", "/a.jpg.txt"), "");
+    CHECK_EQUAL(route(router, "POST", "/img/other.png"), "");
+}
+
+void testHead() {
+    Router router;
+    router.add(Method::kGet, "/page", handler("get page"));
+    router.add(Method::kGet, "/user/:id", handler("get user"));
+    router.add(Method::kHead, "/head", handler("head"));
+    router.add(Method::kGet, "/head", handler("get head"));
+    router.addExtension(Method::kGet, ".html", handler("get html"));
+
+    // HEAD falls back to GET everywhere
+    CHECK_EQUAL(route(router, "HEAD", "/page"), "get page");
+    CHECK_EQUAL(route(router, "HEAD", "/user/1"), "get user id=1");
+    CHECK_EQUAL(route(router, "HEAD", "/index.html"), "get html");
+    // unless it has its own handler
+    CHECK_EQUAL(route(router, "HEAD", "/head"), "head");
+    // but not the other way round, nor for other methods
+    router.add(Method::kHead, "/only-head", handler("only head"));
+    CHECK_EQUAL(route(router, "GET", "/only-head"), "");
+    CHECK_EQUAL(route(router, "POST", "/page"), "");
+}
+
+void testNotFound() {
+    Router router;
+    router.add(Method::kGet, "/page", handler("page"));
+    router.setNotFound(handler("not found"));
+
+    HttpRequest req;
+    const char get[] = "GET";
+    const char path[] = "/missing";
+    req.setMethod(get, get + 3);
+    req.setPath(path, path + ::strlen(path));
+    HttpResponse resp(false);
+    CHECK_EQUAL(router.route(req, &resp), false);
+    CHECK_EQUAL(matched, "not found");
+    CHECK_EQUAL(route(router, "GET", "/page"), "page");
+}
+
+int main() {
+    testExact();
+    testParams();
+    testBacktracking();
+    testWildcard();
+    testExtensions();
+    testHead();
+    testNotFound();
+}
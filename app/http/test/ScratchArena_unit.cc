@@ -0,0 +1,81 @@
+#include <LuteBase.h>
+#include <http/ScratchArena.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace Lute;
+using namespace Lute::http;
+
+#define STR(x) #x
+#define CHECK_EQUAL(x, y)                              \
+    printf("%s %s:%d %s @ %s\n",                       \
+           ((x) != (y)) ? ("[ " RED "Faild" CLR " ] ") \
+                        : ("[ " GREEN "ok" CLR " ]"),  \
+           __FILE__, __LINE__, STR(x), STR(y))
+
+void testConcat() {
+    ScratchArena::Scope scope;
+    std::string_view path =
+        scope.arena().concat({"/var/www", "/index.html"});
+    CHECK_EQUAL(path, std::string_view("/var/www/index.html"));
+    // usable as a C string
+    CHECK_EQUAL(::strlen(path.data()), path.size());
+}
+
+void testRewind() {
+    ScratchArena& arena = ScratchArena::current();
+    CHECK_EQUAL(arena.used(), 0u);
+    {
+        ScratchArena::Scope outer;
+        char* a = arena.allocate(100);
+        size_t mark = arena.used();
+        {
+            ScratchArena::Scope inner;
+            arena.allocate(1000);
+        }
+        CHECK_EQUAL(arena.used(), mark);
+        // the next request gets the same memory
+        char* b = arena.allocate(8);
+        CHECK_EQUAL(b, a + 112);
+    }
+    CHECK_EQUAL(arena.used(), 0u);
+}
+
+void testAlignment() {
+    ScratchArena::Scope scope;
+    scope.arena().allocate(3, 1);
+    char* p = scope.arena().allocate(sizeof(double), alignof(double));
+    CHECK_EQUAL(reinterpret_cast<uintptr_t>(p) % alignof(double), 0u);
+}
+
+void testOverflow() {
+    ScratchArena& arena = ScratchArena::current();
+    {
+        ScratchArena::Scope scope;
+        arena.allocate(ScratchArena::kSize - 10);
+        char* big = arena.allocate(64);
+        ::memset(big, 'x', 64);
+        CHECK_EQUAL(arena.overflowBlocks(), 1u);
+        CHECK_EQUAL(arena.used() <= ScratchArena::kSize, true);
+    }
+    CHECK_EQUAL(arena.overflowBlocks(), 0u);
+}
+
+void testPerThread() {
+    ScratchArena* main = &ScratchArena::current();
+    ScratchArena* other = nullptr;
+    std::thread t([&other] { other = &ScratchArena::current(); });
+    t.join();
+    CHECK_EQUAL(main != other, true);
+}
+
+int main() {
+    testConcat();
+    testRewind();
+    testAlignment();
+    testOverflow();
+    testPerThread();
+}
@@ -8,5 +8,6 @@
 #include <polaris/EventLoop.h>
 #include <polaris/InetAddress.h>
 #include <polaris/TCPClient.h>
+#include <polaris/TCPClientPool.h>
 #include <polaris/TCPConnection.h>
 #include <polaris/TCPServer.h>
\ No newline at end of file
@@ -57,6 +57,8 @@ public:
 
     inline bool listenning() const { return listenning_; }
     void listen();
+    /// Where it is bound, e.g. with the port picked for port 0.
+    InetAddress localAddress() const;
 };
 
 }  // namespace Lute
@@ -395,8 +395,10 @@ public:
     /// Read data directly into buffer.
     ///
     /// It may implement with readv(2)
+    /// @param maxBytes reads no more than that, e.g. a loop's read budget
     /// @return result of read(2), @c errno is saved
-    ssize_t readFd(int fd, int* savedErrno);
+    ssize_t readFd(int fd, int* savedErrno,
+                   size_t maxBytes = static_cast<size_t>(-1));
 
 private:
     inline char* begin() { return &*buffer_.begin(); }
@@ -37,6 +37,22 @@ public:
     void handleEvent(Timestamp receiveTime);
 
     /// @brief Set callback
+    /// Called instead of the callbacks, a plain function call for the
+    /// hottest channels. It looks at revents() itself.
+    using EventHandler = void (*)(void* owner, Timestamp receiveTime);
+    inline void setEventHandler(EventHandler handler, void* owner) {
+        eventHandler_ = handler;
+        owner_ = owner;
+    }
+
+    /// The loop's own fds. EPollPoller tags them in epoll_data and reports
+    /// them by Poller::internalEvents(), so the loop calls their handlers
+    /// directly. Other pollers return them as channels, the callbacks
+    /// still have to be set.
+    enum Internal { kNotInternal = 0, kWakeupFd = 1, kTimerFd = 2 };
+    inline void setInternal(Internal internal) { internal_ = internal; }
+    inline Internal internal() const { return internal_; }
+
     inline void setReadCallback(ReadEventCallback cb) {
         readCallback_ = std::move(cb);
     }
@@ -57,8 +73,7 @@ public:
     inline int fd() const { return fd_; }
     inline int events() const { return events_; }
     inline void set_revents(int revt) { revents_ = revt; }
-    // used by pollers
-    // int revents() const { return revents_; }
+    inline int revents() const { return revents_; }
     inline bool isNoneEvent() const { return events_ == kNoneEvent; }
 
     inline void enableReading() {
@@ -94,6 +109,12 @@ public:
 
     inline void doNotLogHup() { logHup_ = false; }
 
+    /// Handled before the other active channels of an iteration, e.g.
+    /// timers, so they don't wait for a burst of IO. The poller orders
+    /// them as it returns them.
+    inline void setHighPriority(bool on) { highPriority_ = on; }
+    inline bool highPriority() const { return highPriority_; }
+
     inline EventLoop* ownerLoop() { return loop_; }
     void remove();
 
@@ -112,12 +133,16 @@ private:
     int revents_;
     int index_;
     bool logHup_;
+    bool highPriority_;
+    Internal internal_;
 
     // TODO tie_ ???
     std::weak_ptr<void> tie_;
     bool tied_;
     bool eventHandling_;
     bool addedToLoop_;
+    EventHandler eventHandler_;
+    void* owner_;
     ReadEventCallback readCallback_;
     EventCallback writeCallback_;
     EventCallback closeCallback_;
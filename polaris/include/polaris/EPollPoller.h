@@ -25,6 +25,10 @@ struct epoll_event;
 namespace Lute {
 
 /// IO Multiplexing with epoll(4).
+///
+/// Interest changes are collected and handed to epoll_ctl(2) just before
+/// the next epoll_wait(2), and only if they differ from what the kernel
+/// has. Removals go to the kernel at once.
 class EPollPoller : public Poller {
 public:
     EPollPoller(EventLoop* loop);
@@ -39,12 +43,28 @@ private:
     // XXX init with 16, for better performance?
     static const int kInitEventListSize = 16;
 
+    // not in the epoll set
+    static const int kUnregistered = -1;
+
+    struct Slot {
+        // events the kernel has, or kUnregistered
+        int registered;
+        // in dirty_
+        bool dirty;
+    };
+
     int epollfd_;
     EventList events_;
+    // indexed by fd, like channels_
+    std::vector<Slot> slots_;
+    // fds whose events changed since the last poll()
+    std::vector<int> dirty_;
 
     static const char* operationToString(int op);
 
-    void fillActiveChannels(int numEvents, ChannelList* activeChannels) const;
+    void fillActiveChannels(int numEvents, ChannelList* activeChannels);
+    /// epoll_ctl for what changed since the last poll(), if anything did.
+    void applyUpdates();
     void update(int operation, Channel* channel);
 };
 
@@ -9,8 +9,10 @@
 #include <polaris/Callbacks.h>
 #include <polaris/TimerId.h>
 
+#include <array>
 #include <atomic>
 #include <functional>
+#include <string>
 #include <vector>
 namespace Lute {
 
@@ -29,6 +31,15 @@ class EventLoop {
 public:
     using Functor = std::function<void()>;
 
+    /// Bytes a connection reads per iteration, the rest waits for the next
+    /// one so a chatty peer can't hold up the others.
+    static const size_t kDefaultReadBudget = 128 * 1024;
+    /// Functors run per iteration, the rest runs next iteration.
+    static const size_t kDefaultFunctorBudget = 1024;
+    /// Bucket i < 15 counts iterations under 2^i us, the last the rest.
+    static const size_t kNumIterationBuckets = 16;
+    using IterationHistogram = std::array<int64_t, kNumIterationBuckets>;
+
 private:
     using ChannelList = std::vector<Channel*>;
 
@@ -42,6 +53,25 @@ private:
     int64_t iteration_;
     const pid_t threadId_;
     Timestamp pollReturnTime_;
+    // see now()
+    Timestamp now_;
+
+    // busy polling, 0 always blocks
+    int busyPollUs_;
+    // last poll that returned events
+    Timestamp lastActive_;
+    int64_t spinHits_;
+    int64_t spinMisses_;
+    int64_t sleeps_;
+
+    size_t readBudget_;
+    size_t functorBudget_;
+    // over functorBudget_ last iteration
+    bool functorsLeft_;
+    // see setIterationHistogram()
+    bool recordIterations_;
+    // time from poll return to the end of an iteration with work
+    IterationHistogram iterationHistogram_;
 
     // poller
     std::unique_ptr<Poller> poller_;
@@ -63,7 +93,9 @@ private:
     void abortNotInLoopThread();
     // waked up
     void handleRead();
-    void doPendingFunctors();
+    /// @return number of functors run
+    size_t doPendingFunctors();
+    void recordIteration(Timestamp now);
 
     // DEBUG
     void printActiveChannels() const;
@@ -84,8 +116,64 @@ public:
     /// Time when poll returns, usually means data arrival.
     Timestamp pollReturnTime() const { return pollReturnTime_; }
 
+    /// The loop's clock, read once per iteration when poll returns instead
+    /// of by every handler and timer. It lags the real time by as much as
+    /// the iteration has taken so far, fine for receive times and timeouts.
+    /// Not thread safe, call in the loop thread.
+    Timestamp now() const { return now_; }
+    /// Reads the clock, and refreshes now() with it.
+    /// Not thread safe, call in the loop thread.
+    Timestamp preciseNow() {
+        now_ = Timestamp::now();
+        return now_;
+    }
+
     int64_t iteration() const { return iteration_; }
 
+    /// Polls without blocking for @c us microseconds after the last events,
+    /// then blocks again. It burns a core to save the wakeup on the next
+    /// request, so it's for latency sensitive loops that are rarely idle.
+    /// 0 turns it off, the default. Not thread safe, call in the loop thread.
+    void setBusyPoll(int us) { busyPollUs_ = us; }
+    int busyPoll() const { return busyPollUs_; }
+    /// Non-blocking polls that found events, and those that found none.
+    int64_t spinHits() const { return spinHits_; }
+    int64_t spinMisses() const { return spinMisses_; }
+    /// Blocking polls.
+    int64_t sleeps() const { return sleeps_; }
+
+    /// Per iteration budgets, see kDefaultReadBudget and
+    /// kDefaultFunctorBudget. Not thread safe, call in the loop thread.
+    void setReadBudget(size_t bytes) {
+        // a read of 0 bytes would look like the peer's close
+        assert(bytes > 0);
+        readBudget_ = bytes;
+    }
+    size_t readBudget() const { return readBudget_; }
+    void setFunctorBudget(size_t functors) {
+        assert(functors > 0);
+        functorBudget_ = functors;
+    }
+
+    /// Records iterationHistogram(), off by default: it reads the clock
+    /// once more at the end of every iteration with work.
+    /// Not thread safe, call in the loop thread.
+    void setIterationHistogram(bool on) { recordIterations_ = on; }
+    /// How long iterations take, a loop is overloaded once they get
+    /// longer than the latency it is meant to keep. Empty unless turned on
+    /// by setIterationHistogram().
+    /// Not thread safe, read in the loop thread, e.g. from runEvery().
+    const IterationHistogram& iterationHistogram() const {
+        return iterationHistogram_;
+    }
+    /// Non-empty buckets, e.g. "<64us:10 <128us:2"
+    std::string iterationHistogramToString() const;
+
+    /// See Poller::numUpdates() and numUpdatesSaved().
+    /// Not thread safe, read in the loop thread.
+    int64_t pollerUpdates() const;
+    int64_t pollerUpdatesSaved() const;
+
     /// Runs callback immediately in the loop thread.
     /// It wakes up the loop, and run the cb.
     /// If in the same loop thread, cb is run within the function.
@@ -0,0 +1,94 @@
+/**
+ * @file IoUringPoller.h
+ * @brief
+ */
+
+#pragma once
+
+#include <polaris/Poller.h>
+
+#include <vector>
+
+// <linux/io_uring.h>
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace Lute {
+
+/// IO Multiplexing with io_uring(7), readiness only.
+///
+/// Every channel with events has one one-shot IORING_OP_POLL_ADD in flight,
+/// armed again on the next poll() after it fires. As a one-shot poll
+/// completes at once if the fd is still ready, that is level triggered,
+/// like EPollPoller. The arming of all channels goes to the kernel in the
+/// same io_uring_enter(2) that waits, instead of one epoll_ctl(2) each.
+///
+/// Needs Linux 5.11 (IORING_FEAT_EXT_ARG), see supported().
+class IoUringPoller : public Poller {
+public:
+    IoUringPoller(EventLoop* loop);
+    ~IoUringPoller() override;
+
+    Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+    void updateChannel(Channel* channel) override;
+    void removeChannel(Channel* channel) override;
+
+    /// Whether this kernel lets us set up a ring, e.g. not in containers
+    /// that filter io_uring_setup(2).
+    static bool supported();
+
+private:
+    static const unsigned kRingEntries = 1024;
+
+    struct Entry {
+        // nullptr if the fd has no channel
+        Channel* channel;
+        // tells completions of an older poll on the fd apart
+        uint32_t gen;
+        // events of the poll in flight, 0 if none is
+        int armedEvents;
+        bool queued;
+    };
+
+    int ringFd_;
+    // mmapped rings
+    void* sqRing_;
+    size_t sqRingSize_;
+    void* cqRing_;
+    size_t cqRingSize_;
+    io_uring_sqe* sqes_;
+    size_t sqesSize_;
+
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe* cqes_;
+
+    // sqes up to here are filled, the kernel sees them on enter()
+    unsigned sqLocalTail_;
+
+    uint32_t nextGen_;
+    // indexed by fd, like channels_
+    std::vector<Entry> entries_;
+    // fds to arm on the next poll()
+    std::vector<int> toArm_;
+
+    inline Entry* findEntry(int fd) {
+        const size_t i = static_cast<size_t>(fd);
+        return i < entries_.size() && entries_[i].channel ? &entries_[i]
+                                                          : nullptr;
+    }
+    io_uring_sqe* getSqe();
+    int enter(unsigned minComplete, int timeoutMs);
+    void arm(int fd, Entry& entry);
+    void disarm(int fd, Entry& entry);
+    void queueArm(int fd, Entry& entry);
+    void fillActiveChannels(ChannelList* activeChannels);
+    uint32_t nextGen();
+};
+
+}  // namespace Lute
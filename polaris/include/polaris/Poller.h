@@ -30,7 +30,6 @@
 #include <LuteBase.h>
 #include <polaris/EventLoop.h>
 
-#include <map>
 #include <vector>
 
 namespace Lute {
@@ -66,14 +65,47 @@ public:
 
     virtual bool hasChannel(Channel* channel) const;
 
+    enum class Backend { kEPoll, kIoUring };
+
+    /// Backend of the loops created afterwards. kEPoll unless the
+    /// environment has Lute_USE_IOURING. kIoUring falls back to epoll if
+    /// the kernel can't do it, see IoUringPoller::supported().
+    static void setDefaultBackend(Backend backend);
     static Poller* newDefaultPoller(EventLoop* loop);
 
     void assertInLoopThread() const { ownerLoop_->assertInLoopThread(); }
 
+    /// Changes of interest handed to the kernel, e.g. epoll_ctl(2) calls,
+    /// and those it was spared because nothing changed in effect.
+    int64_t numUpdates() const { return numUpdates_; }
+    int64_t numUpdatesSaved() const { return numUpdatesSaved_; }
+
+    /// Channel::Internal bits of the loop's own fds that fired in the last
+    /// poll(), they are not in its activeChannels.
+    int internalEvents() const { return internalEvents_; }
+
 protected:
-    // <fd, Channel>
-    using ChannelMap = std::map<int, Channel*>;
+    // indexed by fd, nullptr where none is; fds are small and dense
+    using ChannelMap = std::vector<Channel*>;
     ChannelMap channels_;
+    size_t numChannels_;
+    int64_t numUpdates_;
+    int64_t numUpdatesSaved_;
+    int internalEvents_;
+
+    inline Channel* findChannel(int fd) const {
+        const size_t i = static_cast<size_t>(fd);
+        return i < channels_.size() ? channels_[i] : nullptr;
+    }
+    /// Grows channels_ on demand.
+    void insertChannel(Channel* channel);
+    void eraseChannel(Channel* channel);
+
+    /// Appends @c channel to those of this poll, which start at @c first,
+    /// but Channel::highPriority() ones before the others. Only those pay
+    /// for more than a push_back().
+    static void addActiveChannel(ChannelList* activeChannels, size_t first,
+                                 Channel* channel);
 
 private:
     EventLoop* ownerLoop_;
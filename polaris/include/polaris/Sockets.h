@@ -119,6 +119,11 @@ public:
     /// Enable/disable SO_KEEPALIVE
     void setKeepAlive(bool on);
 
+    /// SO_BUSY_POLL, busy polls the device queue for @c us microseconds
+    /// when there is no data. 0 turns it off. Above the net.core.busy_read
+    /// sysctl it needs CAP_NET_ADMIN.
+    void setBusyPoll(int us);
+
 private:
     const int sockfd_;  // socket file descriptor
 };
@@ -0,0 +1,190 @@
+/**
+ * @file TCPClientPool.h
+ * @brief
+ */
+
+#pragma once
+
+#include <LuteBase.h>
+#include <polaris/TCPClient.h>
+#include <polaris/TimerId.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace Lute {
+
+class EventLoopThreadPool;
+
+/// Warm connections to one server, spread over a thread pool.
+///
+/// Every connection is a TCPClient that reconnects when it drops. acquire()
+/// leases the connected one with the fewest outstanding requests, i.e.
+/// leases not yet destroyed, so slow connections get less new work. The
+/// reply arrives on the message callback, in the connection's loop, and
+/// matching it to its request is up to the protocol, e.g. in order as with
+/// Redis; the lease is dropped once it is in, or the connection is down.
+///
+/// A connection with leases out that makes no progress, no message and no
+/// lease back, for requestTimeout is closed, and connects again. Idle ones
+/// can be probed by a health check callback, e.g. with a PING, its lease
+/// held until the reply.
+class TCPClientPool {
+    struct Slot;
+
+public:
+    class Lease;
+    using LeasePtr = std::shared_ptr<Lease>;
+    using ThreadInitCallback = std::function<void(EventLoop*)>;
+    /// Called in the connection's loop, see setHealthCheck.
+    using HealthCheckCallback = std::function<void(const LeasePtr&)>;
+
+    /// A request in flight on a connection, given back when destroyed.
+    class Lease {
+        friend class TCPClientPool;
+
+        TCPClientPool* pool_;
+        Slot* slot_;
+        TCPConnectionPtr conn_;
+        bool broken_;
+
+    public:
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        Lease(TCPClientPool* pool, Slot* slot, const TCPConnectionPtr& conn)
+            : pool_(pool), slot_(slot), conn_(conn), broken_(false) {}
+        ~Lease();
+
+        const TCPConnectionPtr& connection() const { return conn_; }
+        EventLoop* getLoop() const { return conn_->getLoop(); }
+        /// Closes the connection when given back, e.g. after a reply that
+        /// can't be parsed. It connects again.
+        void markBroken() { broken_ = true; }
+    };
+
+    struct Metrics {
+        int size;
+        int connected;
+        int outstanding;
+
+        int64_t acquires;
+        // acquires that found no connection up
+        int64_t failures;
+        // connections closed by the health check
+        int64_t unhealthy;
+    };
+
+    static constexpr double kDefaultHealthCheckInterval = 1.0;
+    static constexpr double kDefaultRequestTimeout = 5.0;
+
+    // non-copyable
+    TCPClientPool(const TCPClientPool&) = delete;
+    TCPClientPool& operator=(TCPClientPool&) = delete;
+
+    TCPClientPool(EventLoop* loop, const InetAddress& serverAddr,
+                  const std::string& nameArg);
+    /// In the loop thread, leases must be gone by then.
+    ~TCPClientPool();
+
+    inline const std::string& name() const { return name_; }
+    inline EventLoop* getLoop() const { return loop_; }
+
+    /// Threads for the connections, see TCPServer::setThreadNum.
+    /// Must be called before @c start
+    void setThreadNum(int numThreads);
+    inline void setThreadInitCallback(const ThreadInitCallback& cb) {
+        threadInitCallback_ = cb;
+    }
+    /// Connections kept open, assigned to the threads round-robin.
+    /// 0 means one per thread, the default. Must be called before @c start
+    inline void setConnectionNum(int numConnections) {
+        assert(0 <= numConnections);
+        numConnections_ = numConnections;
+    }
+    /// Checks every connection each @c interval seconds, see the class
+    /// comment. Defaults to kDefaultHealthCheckInterval and
+    /// kDefaultRequestTimeout, without probes.
+    /// Must be called before @c start
+    inline void setHealthCheck(double interval, double requestTimeout,
+                               const HealthCheckCallback& cb) {
+        healthCheckInterval_ = interval;
+        requestTimeout_ = requestTimeout;
+        healthCheckCallback_ = cb;
+    }
+
+    /// Set connection callback.
+    /// Not thread safe.
+    inline void setConnectionCallback(const ConnectionCallback& cb) {
+        connectionCallback_ = cb;
+    }
+    /// Set message callback.
+    /// Not thread safe.
+    inline void setMessageCallback(const MessageCallback& cb) {
+        messageCallback_ = cb;
+    }
+    /// Set write complete callback.
+    /// Not thread safe.
+    inline void setWriteCompleteCallback(const WriteCompleteCallback& cb) {
+        writeCompleteCallback_ = cb;
+    }
+
+    /// Starts the threads and connects.
+    /// Must be called in the loop thread, once.
+    void start();
+
+    /// The connected connection with the fewest leases out, nullptr if none
+    /// is up. Thread safe, after start().
+    LeasePtr acquire();
+
+    /// Thread safe.
+    Metrics metrics() const;
+
+private:
+    struct Slot {
+        std::unique_ptr<TCPClient> client;
+        EventLoop* loop;
+        TimerId healthCheck;
+        std::atomic<bool> connected;
+        // leases out
+        std::atomic<int> outstanding;
+        // microseconds since epoch of the last message or lease back
+        std::atomic<int64_t> lastProgress;
+    };
+
+    EventLoop* loop_;
+    const InetAddress serverAddr_;
+    const std::string name_;
+    std::shared_ptr<EventLoopThreadPool> threadPool_;
+    int numConnections_;
+
+    ConnectionCallback connectionCallback_;
+    MessageCallback messageCallback_;
+    WriteCompleteCallback writeCompleteCallback_;
+    ThreadInitCallback threadInitCallback_;
+    double healthCheckInterval_;
+    double requestTimeout_;
+    HealthCheckCallback healthCheckCallback_;
+
+    // fixed after start()
+    std::vector<std::unique_ptr<Slot>> slots_;
+    // where acquire() starts looking, spreads ties
+    std::atomic<uint32_t> next_;
+    std::atomic<int64_t> acquires_;
+    std::atomic<int64_t> failures_;
+    std::atomic<int64_t> unhealthy_;
+
+    LeasePtr makeLease(Slot* slot, const TCPConnectionPtr& conn);
+    /// Thread safe.
+    void release(Slot* slot, const TCPConnectionPtr& conn, bool broken);
+
+    /// Not thread safe, but in the slot's loop
+    void onConnection(Slot* slot, const TCPConnectionPtr& conn);
+    void onMessage(Slot* slot, const TCPConnectionPtr& conn, Buffer* buf,
+                   Timestamp receiveTime);
+    void checkHealth(Slot* slot);
+    void destroyInLoop(Slot* slot, CountDownLatch* latch);
+};
+
+}  // namespace Lute
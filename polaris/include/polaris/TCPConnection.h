@@ -74,6 +74,8 @@ public:
     void forceCloseWithDelay(double seconds);
 
     void setTcpNoDelay(bool on);
+    /// SO_BUSY_POLL, see Socket::setBusyPoll
+    void setBusyPoll(int us);
     // reading or not
     void startRead();
     void stopRead();
@@ -105,6 +107,31 @@ public:
         highWaterMark_ = highWaterMark;
     }
 
+    /// Stops reading once @c highMark bytes wait in the output buffer, and
+    /// starts again when the peer has drained it to @c lowMark, so a peer
+    /// that sends but never reads cannot grow it without bound. A message
+    /// callback may leave input unparsed while flowPaused(); if any is left,
+    /// it is called again once reading resumes.
+    /// 0 turns it off. NOT thread safe, call before connectEstablished().
+    inline void setFlowControl(size_t highMark, size_t lowMark) {
+        flowHighMark_ = highMark;
+        flowLowMark_ = lowMark;
+    }
+    /// True while reading is stopped by flow control.
+    bool flowPaused() const { return flowPaused_; }
+
+    /// Loop-confined mode: from connectEstablished() to connectDestroyed()
+    /// the connection holds itself, and callbacks in the loop thread get a
+    /// reference to that instead of a copy from shared_from_this(). The
+    /// channel is not tied then, so dispatching an event touches no
+    /// reference count. Off by default.
+    /// NOT thread safe, call before connectEstablished().
+    inline void setLoopConfined(bool on) {
+        assert(state_ == StateE::kConnecting);
+        loopConfined_ = on;
+    }
+    bool loopConfined() const { return loopConfined_; }
+
     /// Advanced interface
     inline Buffer* inputBuffer() { return &inputBuffer_; }
 
@@ -151,17 +178,27 @@ private:
     CloseCallback closeCallback_;
 
     size_t highWaterMark_;
+    size_t flowHighMark_;
+    size_t flowLowMark_;
+    bool flowPaused_;
+    bool loopConfined_;
     Buffer inputBuffer_;
     Buffer outputBuffer_;  // FIXME: use list<Buffer> as output buffer.
     Lute::any context_;
+    // this while established in loop-confined mode, see setLoopConfined()
+    TCPConnectionPtr self_;
     // FIXME: creationTime_, lastReceiveTime_
     //        bytesReceived_, bytesSent_
 
 private:
+    /// Channel::EventHandler, dispatches without the std::function calls.
+    static void handleEvent(void* self, Timestamp receiveTime);
     void handleRead(Timestamp receiveTime);
     void handleWrite();
     void handleClose();
     void handleError();
+    /// self_ in loop-confined mode, else a copy of this put in @c guard.
+    const TCPConnectionPtr& selfRef(TCPConnectionPtr* guard);
 
     // void sendInLoop(string&& message);
     // XXX std::string_view
@@ -175,6 +212,9 @@ private:
     const char* stateToString() const;
     void startReadInLoop();
     void stopReadInLoop();
+    void pauseReadForOutput();
+    void resumeReadForOutput();
+    void redeliverInput();
 };
 
 /// Define
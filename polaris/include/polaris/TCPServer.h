@@ -32,6 +32,8 @@ public:
     ~TCPServer();  // force out-line dtor, for std::unique_ptr members.
 
     inline const std::string& ipPort() const { return ipPort_; }
+    /// Unlike ipPort(), with the port picked when constructed with port 0.
+    InetAddress listenAddress() const;
     inline const std::string& name() const { return name_; }
     inline EventLoop* getLoop() const { return loop_; }
 
@@ -79,6 +81,26 @@ public:
         writeCompleteCallback_ = cb;
     }
 
+    /// Flow control of new connections, see TCPConnection::setFlowControl.
+    /// Defaults to kDefaultFlowHighMark and kDefaultFlowLowMark.
+    /// Not thread safe.
+    inline void setFlowControl(size_t highMark, size_t lowMark) {
+        flowHighMark_ = highMark;
+        flowLowMark_ = lowMark;
+    }
+
+    /// Busy polls the IO loops for @c us microseconds after activity, see
+    /// EventLoop::setBusyPoll, and sets SO_BUSY_POLL on new connections.
+    /// 0 turns it off, the default. Must be called before @c start
+    inline void setBusyPoll(int us) { busyPollUs_ = us; }
+
+    /// New connections in loop-confined mode, see
+    /// TCPConnection::setLoopConfined. Off by default. Not thread safe.
+    inline void setLoopConfined(bool on) { loopConfined_ = on; }
+
+    static const size_t kDefaultFlowHighMark = 64 * 1024 * 1024;
+    static const size_t kDefaultFlowLowMark = 16 * 1024 * 1024;
+
 private:
     using ConnectionMap = std::map<std::string, TCPConnectionPtr>;
 
@@ -96,6 +118,10 @@ private:
     MessageCallback messageCallback_;
     WriteCompleteCallback writeCompleteCallback_;
     ThreadInitCallback threadInitCallback_;
+    size_t flowHighMark_;
+    size_t flowLowMark_;
+    int busyPollUs_;
+    bool loopConfined_;
 
     AtomicInt32 started_;
     // always in loop thread
@@ -42,6 +42,9 @@ public:
 
     void cancel(TimerId timerId);
 
+    /// Called by EventLoop when timerfd alarms, not through the channel.
+    void handleRead();
+
 private:
     // FIXME: use unique_ptr<Timer> instead of raw pointers.
     // This requires heterogeneous comparison lookup (N3465) from C++14
@@ -65,8 +68,6 @@ private:
 private:
     void addTimerInLoop(Timer* timer);
     void cancelInLoop(TimerId timerId);
-    // called when timerfd alarms
-    void handleRead();
     // move out all expired timers
     std::vector<Entry> getExpired(Timestamp now);
     void reset(const std::vector<Entry>& expired, Timestamp now);
@@ -46,6 +46,10 @@ void Acceptor::listen() {
     acceptChannel_.enableReading();
 }
 
+InetAddress Acceptor::localAddress() const {
+    return InetAddress(sockets::getLocalAddr(acceptSocket_.fd()));
+}
+
 void Acceptor::handleRead() {
     loop_->assertInLoopThread();
     InetAddress peerAddr;
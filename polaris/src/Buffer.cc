@@ -8,6 +8,8 @@
 #include <polaris/Sockets.h>
 #include <sys/uio.h>
 
+#include <algorithm>
+
 using namespace Lute;
 
 /// k - konstant
@@ -23,7 +25,7 @@ const size_t Buffer::kInitialSize;
 /// @param savedErrno
 /// @return
 ///
-ssize_t Buffer::readFd(int fd, int* savedErrno) {
+ssize_t Buffer::readFd(int fd, int* savedErrno, size_t maxBytes) {
     // saved an ioctl()/FIONREAD call to tell how much to read
     char extrabuf[65536];
 
@@ -31,14 +33,15 @@ ssize_t Buffer::readFd(int fd, int* savedErrno) {
     struct iovec vec[2];
     const size_t writeable = writableBytes();
     vec[0].iov_base = begin() + writerIndex_;
-    vec[0].iov_len = writeable;
+    vec[0].iov_len = std::min(writeable, maxBytes);
 
     vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof(extrabuf);
+    vec[1].iov_len = std::min(sizeof(extrabuf), maxBytes - vec[0].iov_len);
 
     /// When there is enough space in this buff, don't read into extrabuf
     /// When extrabuf is used, we read 128k-1 bytes at most.
-    const int iovcnt = (writeable < sizeof(extrabuf)) ? 2 : 1;
+    const int iovcnt =
+        (writeable < sizeof(extrabuf) && vec[1].iov_len > 0) ? 2 : 1;
     const ssize_t n = sockets::readv(fd, vec, iovcnt);
     if (n < 0) {
         *savedErrno = errno;
@@ -23,9 +23,13 @@ Channel::Channel(EventLoop* loop, int fd)
       revents_(0),
       index_(-1),
       logHup_(true),
+      highPriority_(false),
+      internal_(kNotInternal),
       tied_(false),
       eventHandling_(false),
-      addedToLoop_(false) {}
+      addedToLoop_(false),
+      eventHandler_(nullptr),
+      owner_(nullptr) {}
 
 Channel::~Channel() {
     assert(!eventHandling_);
@@ -62,6 +66,11 @@ void Channel::update() {
 void Channel::handleEventWithGuard(Timestamp receiveTime) {
     eventHandling_ = true;
     LOG_TRACE << reventsToString();
+    if (eventHandler_) {
+        eventHandler_(owner_, receiveTime);
+        eventHandling_ = false;
+        return;
+    }
 
     // POLLHUP - Hang up
     // 与文件描述符相关的连接已经被挂起或者被挂断，
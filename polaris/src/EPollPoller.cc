@@ -27,9 +27,15 @@ static_assert(EPOLLHUP == POLLHUP, "epoll uses same flag values as poll");
 namespace {
 const int kNew = -1;
 const int kAdded = 1;
-const int kDeleted = 2;
+
+// Channel::Internal in the low bits of epoll_data, free as Channels are
+// aligned
+const uint64_t kInternalMask = 3;
+static_assert(alignof(Channel) > kInternalMask, "no room for the tag");
 }  // namespace
 
+const int EPollPoller::kUnregistered;
+
 /**
  * @brief Set eventLoop and Create epoll
  */
@@ -55,7 +61,9 @@ EPollPoller::~EPollPoller() { ::close(epollfd_); }
  * @return Timestamp
  */
 Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels) {
-    LOG_TRACE << "fd total count " << channels_.size();
+    LOG_TRACE << "fd total count " << numChannels_;
+    applyUpdates();
+    internalEvents_ = 0;
     int numEvents = ::epoll_wait(epollfd_, &*events_.begin(),
                                  static_cast<int>(events_.size()), timeoutMs);
     int savedErrno = errno;
@@ -82,24 +90,27 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels) {
 }
 
 void EPollPoller::fillActiveChannels(int numEvents,
-                                     ChannelList* activeChannels) const {
+                                     ChannelList* activeChannels) {
     assert(static_cast<size_t>(numEvents) <= events_.size());
+    const size_t first = activeChannels->size();
 
     // 遍历 events_，将其中的 Channel* 指针取出，放入 activeChannels 中
     for (int i = 0; i < numEvents; ++i) {
-        Channel* channel = static_cast<Channel*>(
+        const uint64_t data =
             events_[static_cast<std::vector<EventList>::size_type>(i)]
-                .data.ptr);
+                .data.u64;
+        // the loop's own fds, it only needs to know they fired
+        if (data & kInternalMask) {
+            internalEvents_ |= static_cast<int>(data & kInternalMask);
+            continue;
+        }
+        Channel* channel = reinterpret_cast<Channel*>(data);
 
-        int fd = channel->fd();
-        auto it = channels_.find(fd);
-        assert(it != channels_.end());
-        assert(it->second == channel);
-        (void)it;
+        assert(findChannel(channel->fd()) == channel);
 
         channel->set_revents(static_cast<int>(
             events_[static_cast<std::vector<EventList>::size_type>(i)].events));
-        activeChannels->push_back(channel);
+        addActiveChannel(activeChannels, first, channel);
     }
 }
 
@@ -108,33 +119,24 @@ void EPollPoller::updateChannel(Channel* channel) {
     const int index = channel->index();
     LOG_TRACE << "fd = " << channel->fd() << " events = " << channel->events()
               << " index = " << index;
-    if (index == kNew || index == kDeleted) {
-        // a new one, add with EPOLL_CTL_ADD
-        int fd = channel->fd();
-        if (index == kNew) {
-            assert(channels_.find(fd) == channels_.end());
-            channels_[fd] = channel;
-        } else  // index == kDeleted
-        {
-            assert(channels_.find(fd) != channels_.end());
-            assert(channels_[fd] == channel);
-        }
-
+    if (index == kNew) {
+        insertChannel(channel);
+        // kept as long as channels_
+        slots_.resize(channels_.size(), Slot{kUnregistered, false});
         channel->set_index(kAdded);
-        update(EPOLL_CTL_ADD, channel);
     } else {
-        // update existing one with EPOLL_CTL_MOD/DEL
-        int fd = channel->fd();
-        (void)fd;
-        assert(channels_.find(fd) != channels_.end());
-        assert(channels_[fd] == channel);
+        assert(findChannel(channel->fd()) == channel);
         assert(index == kAdded);
-        if (channel->isNoneEvent()) {
-            update(EPOLL_CTL_DEL, channel);
-            channel->set_index(kDeleted);
-        } else {
-            update(EPOLL_CTL_MOD, channel);
-        }
+    }
+
+    // applied by the next poll(), so changes back and forth in one
+    // iteration cost nothing
+    Slot& slot = slots_[static_cast<size_t>(channel->fd())];
+    if (slot.dirty) {
+        ++numUpdatesSaved_;
+    } else {
+        slot.dirty = true;
+        dirty_.push_back(channel->fd());
     }
 }
 
@@ -142,32 +144,56 @@ void EPollPoller::removeChannel(Channel* channel) {
     Poller::assertInLoopThread();
     int fd = channel->fd();
     LOG_TRACE << "fd = " << fd;
-    assert(channels_.find(fd) != channels_.end());
-    assert(channels_[fd] == channel);
     assert(channel->isNoneEvent());
-    int index = channel->index();
-    assert(index == kAdded || index == kDeleted);
-    size_t n = channels_.erase(fd);
-    (void)n;
-    assert(n == 1);
+    assert(channel->index() == kAdded);
+    eraseChannel(channel);
 
-    if (index == kAdded) {
+    // right away, the channel is about to go and epoll must not return it
+    Slot& slot = slots_[static_cast<size_t>(fd)];
+    if (slot.registered != kUnregistered) {
         update(EPOLL_CTL_DEL, channel);
+        slot.registered = kUnregistered;
     }
     channel->set_index(kNew);
 }
 
+void EPollPoller::applyUpdates() {
+    for (int fd : dirty_) {
+        Slot& slot = slots_[static_cast<size_t>(fd)];
+        slot.dirty = false;
+        Channel* channel = findChannel(fd);
+        // removed meanwhile
+        if (channel == nullptr) continue;
+
+        const int events = channel->events();
+        if (slot.registered == events ||
+            (slot.registered == kUnregistered && events == 0)) {
+            ++numUpdatesSaved_;
+        } else if (slot.registered == kUnregistered) {
+            update(EPOLL_CTL_ADD, channel);
+        } else if (events == 0) {
+            update(EPOLL_CTL_DEL, channel);
+        } else {
+            update(EPOLL_CTL_MOD, channel);
+        }
+        slot.registered = events == 0 ? kUnregistered : events;
+    }
+    dirty_.clear();
+}
+
 void EPollPoller::update(int operation, Channel* channel) {
     struct epoll_event event;
     memZero(&event, sizeof(event));
     event.events = static_cast<uint32_t>(channel->events());
-    event.data.ptr = channel;
+    event.data.u64 = reinterpret_cast<uint64_t>(channel) |
+                     static_cast<uint64_t>(channel->internal());
     int fd = channel->fd();
     LOG_TRACE << "epoll_ctl op = " << operationToString(operation)
               << " fd = " << fd << " event = { " << channel->eventsToString()
               << " }";
 
     // NOTE ::epoll_ctl
+    ++numUpdates_;
     if (::epoll_ctl(epollfd_, operation, fd, &event) < 0) {
         if (operation == EPOLL_CTL_DEL) {
             LOG_SYSERR << "epoll_ctl op =" << operationToString(operation)
@@ -14,9 +14,15 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <cstdio>
+#include <iterator>
 
 using namespace Lute;
 
+const size_t EventLoop::kDefaultReadBudget;
+const size_t EventLoop::kDefaultFunctorBudget;
+const size_t EventLoop::kNumIterationBuckets;
+
 namespace {
 __thread EventLoop* t_loopInThisThread = nullptr;
 
@@ -60,6 +66,16 @@ EventLoop::EventLoop()
       callingPendingFunctors_(false),
       iteration_(0),
       threadId_(CurrentThread::tid()),
+      now_(Timestamp::now()),
+      busyPollUs_(0),
+      spinHits_(0),
+      spinMisses_(0),
+      sleeps_(0),
+      readBudget_(kDefaultReadBudget),
+      functorBudget_(kDefaultFunctorBudget),
+      functorsLeft_(false),
+      recordIterations_(false),
+      iterationHistogram_(),
       poller_(Poller::newDefaultPoller(this)),
       timerQueue_(new TimerQueue(this)),
       wakeupFd_(createEventfd()),
@@ -73,6 +89,7 @@ EventLoop::EventLoop()
         t_loopInThisThread = this;
     }
     wakeupChannel_->setReadCallback(std::bind(&EventLoop::handleRead, this));
+    wakeupChannel_->setInternal(Channel::kWakeupFd);
     // we are always reading the wakeupfd
     wakeupChannel_->enableReading();
 }
@@ -95,21 +112,49 @@ void EventLoop::loop() {
 
     while (!quit_) {
         activeChannels_.clear();
-        pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+        // as of the previous poll, good enough for a budget
+        const int64_t idleUs = pollReturnTime_.microSecondsSinceEpoch() -
+                               lastActive_.microSecondsSinceEpoch();
+        const bool spinning = busyPollUs_ > 0 && idleUs < busyPollUs_;
+        // functors over the budget run next iteration, without waiting
+        const bool blocking = !spinning && !functorsLeft_;
+        pollReturnTime_ =
+            poller_->poll(blocking ? kPollTimeMs : 0, &activeChannels_);
+        now_ = pollReturnTime_;
         ++iteration_;
+        const int internalEvents = poller_->internalEvents();
+        const bool active = !activeChannels_.empty() || internalEvents != 0;
+        if (active) lastActive_ = pollReturnTime_;
+        if (blocking) {
+            ++sleeps_;
+        } else if (spinning) {
+            if (!active) {
+                ++spinMisses_;
+            } else {
+                ++spinHits_;
+            }
+        }
         if (Logger::logLevel() <= Logger::LogLevel::TRACE) {
             printActiveChannels();
         }
 
-        // TODO sort channel by priority
+        // timers first, then IO, then functors; the poller puts high
+        // priority channels first
         eventHandling_ = true;
+        // the loop's own fds, straight to their handlers
+        if (internalEvents & Channel::kTimerFd) timerQueue_->handleRead();
+        if (internalEvents & Channel::kWakeupFd) handleRead();
         for (Channel* channel : activeChannels_) {
             currentActiveChannel_ = channel;
             currentActiveChannel_->handleEvent(pollReturnTime_);
         }
         currentActiveChannel_ = nullptr;
         eventHandling_ = false;
-        doPendingFunctors();
+        const size_t numFunctors = doPendingFunctors();
+
+        if (recordIterations_ && (active || numFunctors > 0)) {
+            recordIteration(preciseNow());
+        }
     }
 
     LOG_TRACE << "EventLoop " << this << " stop looping";
@@ -171,6 +216,12 @@ void EventLoop::removeChannel(Channel* channel) {
     poller_->removeChannel(channel);
 }
 
+int64_t EventLoop::pollerUpdates() const { return poller_->numUpdates(); }
+
+int64_t EventLoop::pollerUpdatesSaved() const {
+    return poller_->numUpdatesSaved();
+}
+
 bool EventLoop::hasChannel(Channel* channel) {
     assert(channel->ownerLoop() == this);
     assertInLoopThread();
@@ -201,19 +252,61 @@ void EventLoop::handleRead() {
     }
 }
 
-void EventLoop::doPendingFunctors() {
+size_t EventLoop::doPendingFunctors() {
     std::vector<Functor> functors;
     callingPendingFunctors_ = true;
 
     {
         MutexLockGuard lock(mutex_);
-        functors.swap(pendingFunctors_);
+        if (pendingFunctors_.size() <= functorBudget_) {
+            functors.swap(pendingFunctors_);
+        } else {
+            // oldest first, the rest keeps its order
+            auto end = pendingFunctors_.begin() +
+                       static_cast<std::ptrdiff_t>(functorBudget_);
+            functors.assign(std::make_move_iterator(pendingFunctors_.begin()),
+                            std::make_move_iterator(end));
+            pendingFunctors_.erase(pendingFunctors_.begin(), end);
+        }
+        functorsLeft_ = !pendingFunctors_.empty();
     }
 
     for (const Functor& functor : functors) {
         functor();
     }
     callingPendingFunctors_ = false;
+    return functors.size();
+}
+
+void EventLoop::recordIteration(Timestamp now) {
+    const int64_t us = now.microSecondsSinceEpoch() -
+                       pollReturnTime_.microSecondsSinceEpoch();
+    size_t bucket = 0;
+    while (bucket + 1 < kNumIterationBuckets &&
+           us >= (static_cast<int64_t>(1) << bucket)) {
+        ++bucket;
+    }
+    ++iterationHistogram_[bucket];
+}
+
+std::string EventLoop::iterationHistogramToString() const {
+    std::string result;
+    char buf[64];
+    for (size_t i = 0; i < kNumIterationBuckets; ++i) {
+        if (iterationHistogram_[i] == 0) continue;
+        if (i + 1 < kNumIterationBuckets) {
+            snprintf(buf, sizeof buf, "<%lldus:%lld ",
+                     static_cast<long long>(1) << i,
+                     static_cast<long long>(iterationHistogram_[i]));
+        } else {
+            snprintf(buf, sizeof buf, ">=%lldus:%lld ",
+                     static_cast<long long>(1) << (i - 1),
+                     static_cast<long long>(iterationHistogram_[i]));
+        }
+        result += buf;
+    }
+    if (!result.empty()) result.pop_back();
+    return result;
 }
 
 void EventLoop::printActiveChannels() const {
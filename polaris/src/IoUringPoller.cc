@@ -0,0 +1,302 @@
+/**
+ * @file IoUringPoller.cc
+ * @brief
+ */
+
+#include <LuteBase.h>
+#include <linux/io_uring.h>
+#include <polaris/Channel.h>
+#include <polaris/IoUringPoller.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+using namespace Lute;
+
+namespace {
+const int kNew = -1;
+const int kAdded = 1;
+
+// user_data of POLL_REMOVE, whose completions are of no interest
+const uint64_t kRemoveToken = 0;
+
+uint64_t makeToken(int fd, uint32_t gen) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(fd)) << 32 | gen;
+}
+
+int setupRing(unsigned entries, struct io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+void* mapRing(int ringFd, size_t size, off_t offset) {
+    return ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ringFd, offset);
+}
+
+template <typename T>
+T* ringField(void* ring, unsigned offset) {
+    return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+}  // namespace
+
+const unsigned IoUringPoller::kRingEntries;
+
+bool IoUringPoller::supported() {
+    struct io_uring_params params;
+    memZero(&params, sizeof params);
+    int fd = setupRing(1, &params);
+    if (fd < 0) return false;
+    ::close(fd);
+    return (params.features & IORING_FEAT_EXT_ARG) != 0;
+}
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+    : Poller(loop),
+      ringFd_(-1),
+      sqRing_(MAP_FAILED),
+      sqRingSize_(0),
+      cqRing_(MAP_FAILED),
+      cqRingSize_(0),
+      sqes_(nullptr),
+      sqesSize_(0),
+      sqLocalTail_(0),
+      nextGen_(0) {
+    struct io_uring_params params;
+    memZero(&params, sizeof params);
+    ringFd_ = setupRing(kRingEntries, &params);
+    if (ringFd_ < 0) {
+        LOG_SYSFATAL << "IoUringPoller::IoUringPoller";
+    }
+    if ((params.features & IORING_FEAT_EXT_ARG) == 0) {
+        LOG_FATAL << "IoUringPoller needs IORING_FEAT_EXT_ARG";
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    // both rings in one mapping since 5.4
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+    sqRing_ = mapRing(ringFd_, sqRingSize_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        LOG_SYSFATAL << "IoUringPoller mmap sq ring";
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = mapRing(ringFd_, cqRingSize_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            LOG_SYSFATAL << "IoUringPoller mmap cq ring";
+        }
+    }
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mapRing(ringFd_, sqesSize_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        LOG_SYSFATAL << "IoUringPoller mmap sqes";
+    }
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+    sqHead_ = ringField<unsigned>(sqRing_, params.sq_off.head);
+    sqTail_ = ringField<unsigned>(sqRing_, params.sq_off.tail);
+    sqMask_ = *ringField<unsigned>(sqRing_, params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+    cqHead_ = ringField<unsigned>(cqRing_, params.cq_off.head);
+    cqTail_ = ringField<unsigned>(cqRing_, params.cq_off.tail);
+    cqMask_ = *ringField<unsigned>(cqRing_, params.cq_off.ring_mask);
+    cqes_ = ringField<struct io_uring_cqe>(cqRing_, params.cq_off.cqes);
+
+    // sqe i always sits in slot i
+    unsigned* array = ringField<unsigned>(sqRing_, params.sq_off.array);
+    for (unsigned i = 0; i < sqEntries_; ++i) array[i] = i;
+    sqLocalTail_ = *sqTail_;
+}
+
+IoUringPoller::~IoUringPoller() {
+    if (sqes_) ::munmap(sqes_, sqesSize_);
+    if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) {
+        ::munmap(cqRing_, cqRingSize_);
+    }
+    if (sqRing_ != MAP_FAILED) ::munmap(sqRing_, sqRingSize_);
+    ::close(ringFd_);
+}
+
+/**
+ * @brief Arms what changed, then waits in one `io_uring_enter`
+ *
+ * @param timeoutMs 最大等待时间，设置为-1表示一直等待
+ * @param activeChannels
+ * @return Timestamp
+ */
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels) {
+    LOG_TRACE << "fd total count " << numChannels_;
+    for (int fd : toArm_) {
+        Entry& entry = entries_[static_cast<size_t>(fd)];
+        // removed meanwhile
+        if (entry.channel == nullptr) continue;
+        entry.queued = false;
+        if (entry.armedEvents == 0 && !entry.channel->isNoneEvent()) {
+            arm(fd, entry);
+        }
+    }
+    toArm_.clear();
+
+    int ret = enter(timeoutMs == 0 ? 0 : 1, timeoutMs);
+    int savedErrno = errno;
+    Timestamp now(Timestamp::now());
+
+    if (ret < 0 && savedErrno != ETIME && savedErrno != EINTR) {
+        errno = savedErrno;
+        LOG_SYSERR << "IoUringPoller::poll()";
+    }
+    const size_t numActive = activeChannels->size();
+    fillActiveChannels(activeChannels);
+    if (activeChannels->size() > numActive) {
+        LOG_TRACE << activeChannels->size() - numActive << " events happened";
+    } else {
+        LOG_TRACE << "nothing happened";
+    }
+    return now;
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList* activeChannels) {
+    const size_t first = activeChannels->size();
+    unsigned head = *cqHead_;
+    const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+        const struct io_uring_cqe& cqe = cqes_[head & cqMask_];
+        if (cqe.user_data == kRemoveToken) continue;
+
+        const int fd = static_cast<int>(cqe.user_data >> 32);
+        const uint32_t gen = static_cast<uint32_t>(cqe.user_data);
+        Entry* entry = findEntry(fd);
+        // an older poll, removed or replaced since
+        if (entry == nullptr || entry->gen != gen) continue;
+
+        entry->armedEvents = 0;
+        if (cqe.res < 0) {
+            LOG_ERROR << "IoUringPoller poll fd = " << fd
+                      << " failed: " << strerror_tl(-cqe.res);
+            entry->channel->set_revents(POLLERR);
+        } else {
+            entry->channel->set_revents(cqe.res);
+        }
+        addActiveChannel(activeChannels, first, entry->channel);
+        // one-shot, armed again next poll() if still wanted
+        queueArm(fd, *entry);
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+}
+
+void IoUringPoller::updateChannel(Channel* channel) {
+    Poller::assertInLoopThread();
+    const int fd = channel->fd();
+    LOG_TRACE << "fd = " << fd << " events = " << channel->events()
+              << " index = " << channel->index();
+    if (channel->index() == kNew) {
+        insertChannel(channel);
+        channel->set_index(kAdded);
+        // kept as long as channels_
+        entries_.resize(channels_.size());
+        Entry& entry = entries_[static_cast<size_t>(fd)];
+        entry = Entry{channel, nextGen(), 0, false};
+        queueArm(fd, entry);
+        return;
+    }
+
+    assert(findChannel(fd) == channel);
+    Entry& entry = entries_[static_cast<size_t>(fd)];
+    if (entry.armedEvents == channel->events()) {
+        ++numUpdatesSaved_;
+        return;
+    }
+    if (entry.armedEvents != 0) disarm(fd, entry);
+    queueArm(fd, entry);
+}
+
+void IoUringPoller::removeChannel(Channel* channel) {
+    Poller::assertInLoopThread();
+    const int fd = channel->fd();
+    LOG_TRACE << "fd = " << fd;
+    assert(channel->isNoneEvent());
+    eraseChannel(channel);
+
+    Entry& entry = entries_[static_cast<size_t>(fd)];
+    if (entry.armedEvents != 0) disarm(fd, entry);
+    entry = Entry();
+    channel->set_index(kNew);
+}
+
+void IoUringPoller::queueArm(int fd, Entry& entry) {
+    if (!entry.queued) {
+        entry.queued = true;
+        toArm_.push_back(fd);
+    }
+}
+
+void IoUringPoller::arm(int fd, Entry& entry) {
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = static_cast<uint32_t>(entry.channel->events());
+    ++numUpdates_;
+    sqe->user_data = makeToken(fd, entry.gen);
+    entry.armedEvents = entry.channel->events();
+}
+
+void IoUringPoller::disarm(int fd, Entry& entry) {
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = makeToken(fd, entry.gen);
+    sqe->user_data = kRemoveToken;
+    // a completion racing with the removal is stale now
+    entry.gen = nextGen();
+    entry.armedEvents = 0;
+}
+
+struct io_uring_sqe* IoUringPoller::getSqe() {
+    if (sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) ==
+        sqEntries_) {
+        // full, hand what we have to the kernel first
+        if (enter(0, 0) < 0 && errno != ETIME && errno != EINTR) {
+            LOG_SYSFATAL << "IoUringPoller::getSqe()";
+        }
+    }
+    struct io_uring_sqe* sqe = &sqes_[sqLocalTail_ & sqMask_];
+    memZero(sqe, sizeof *sqe);
+    ++sqLocalTail_;
+    return sqe;
+}
+
+int IoUringPoller::enter(unsigned minComplete, int timeoutMs) {
+    __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+    const unsigned toSubmit =
+        sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memZero(&arg, sizeof arg);
+    if (timeoutMs >= 0) {
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000 * 1000;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+    return static_cast<int>(
+        ::syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete,
+                  IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg,
+                  sizeof arg));
+}
+
+uint32_t IoUringPoller::nextGen() {
+    // 0 would collide with kRemoveToken on fd 0
+    if (++nextGen_ == 0) ++nextGen_;
+    return nextGen_;
+}
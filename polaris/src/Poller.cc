@@ -5,24 +5,84 @@
 
 #include <polaris/Channel.h>
 #include <polaris/EPollPoller.h>
+#include <polaris/IoUringPoller.h>
 #include <polaris/Poller.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+
 using namespace Lute;
 
-Poller::Poller(EventLoop* loop) : ownerLoop_(loop) {}
+namespace {
+const size_t kInitChannelMapSize = 64;
+}  // namespace
+
+Poller::Poller(EventLoop* loop)
+    : channels_(kInitChannelMapSize, nullptr),
+      numChannels_(0),
+      numUpdates_(0),
+      numUpdatesSaved_(0),
+      internalEvents_(0),
+      ownerLoop_(loop) {}
 
 Poller::~Poller() = default;
 
 bool Poller::hasChannel(Channel* channel) const {
     assertInLoopThread();
-    ChannelMap::const_iterator it = channels_.find(channel->fd());
-    return it != channels_.end() && it->second == channel;
+    return findChannel(channel->fd()) == channel;
+}
+
+void Poller::insertChannel(Channel* channel) {
+    const size_t fd = static_cast<size_t>(channel->fd());
+    if (fd >= channels_.size()) {
+        channels_.resize(std::max(fd + 1, channels_.size() * 2), nullptr);
+    }
+    assert(channels_[fd] == nullptr);
+    channels_[fd] = channel;
+    ++numChannels_;
+}
+
+void Poller::eraseChannel(Channel* channel) {
+    assert(findChannel(channel->fd()) == channel);
+    channels_[static_cast<size_t>(channel->fd())] = nullptr;
+    --numChannels_;
+}
+
+void Poller::addActiveChannel(ChannelList* activeChannels, size_t first,
+                              Channel* channel) {
+    if (!channel->highPriority()) {
+        activeChannels->push_back(channel);
+        return;
+    }
+    // after the high priority ones already there, in poll order
+    auto pos = activeChannels->begin() + static_cast<std::ptrdiff_t>(first);
+    while (pos != activeChannels->end() && (*pos)->highPriority()) ++pos;
+    activeChannels->insert(pos, channel);
+}
+
+namespace {
+std::atomic<Poller::Backend> g_defaultBackend(
+    ::getenv("Lute_USE_IOURING") ? Poller::Backend::kIoUring
+                                 : Poller::Backend::kEPoll);
+}  // namespace
+
+void Poller::setDefaultBackend(Backend backend) {
+    g_defaultBackend = backend;
 }
 
 /// @brief
 /// @param loop
 /// @return
 Poller* Poller::newDefaultPoller(EventLoop* loop) {
+    if (g_defaultBackend == Backend::kIoUring) {
+        // checked once, the kernel won't change
+        static const bool supported = IoUringPoller::supported();
+        if (supported) return new IoUringPoller(loop);
+        LOG_WARN << "io_uring is not supported, use epoll";
+    }
+
     if (::getenv("Lute_USE_POLL")) {
         // BUG pollpoller is not implemented yet
         return new EPollPoller(loop);
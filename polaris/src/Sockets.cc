@@ -429,3 +429,18 @@ void Socket::setKeepAlive(bool on) {
         LOG_ERROR << "set SO_KEEPALIVE failed. errno: " << errno;
     }
 }
+
+void Socket::setBusyPoll(int us) {
+#ifdef SO_BUSY_POLL
+    int optval = us;
+    int ret = ::setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL, &optval,
+                           static_cast<socklen_t>(sizeof optval));
+    if (ret < 0) {
+        LOG_SYSERR << "set SO_BUSY_POLL " << us << " failed.";
+    }
+#else
+    if (us > 0) {
+        LOG_ERROR << "SO_BUSY_POLL is not supported.";
+    }
+#endif
+}
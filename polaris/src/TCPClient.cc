@@ -66,6 +66,7 @@ TCPClient::~TCPClient() {
     bool unique = false;
     {
         MutexLockGuard lock(mutex_);
+        // never loop confined, so no reference of its own to count
         unique = connection_.unique();
         conn = connection_;
     }
@@ -0,0 +1,219 @@
+/**
+ * @file TCPClientPool.cc
+ * @brief
+ */
+
+#include <LuteBase.h>
+#include <polaris/EventLoop.h>
+#include <polaris/EventLoopThreadPool.h>
+#include <polaris/TCPClientPool.h>
+
+#include <climits>
+#include <cstdio>  // snprintf
+
+using namespace Lute;
+
+namespace {
+
+/// The loop's cached clock in its thread, see EventLoop::now().
+Timestamp nowIn(EventLoop* loop) {
+    return loop->isInLoopThread() ? loop->now() : Timestamp::now();
+}
+
+}  // namespace
+
+TCPClientPool::Lease::~Lease() { pool_->release(slot_, conn_, broken_); }
+
+TCPClientPool::TCPClientPool(EventLoop* loop, const InetAddress& serverAddr,
+                             const std::string& nameArg)
+    : loop_(CHECK_NOTNULL(loop)),
+      serverAddr_(serverAddr),
+      name_(nameArg),
+      threadPool_(new EventLoopThreadPool(loop, name_)),
+      numConnections_(0),
+      connectionCallback_(defaultConnectionCallback),
+      messageCallback_(defaultMessageCallback),
+      healthCheckInterval_(kDefaultHealthCheckInterval),
+      requestTimeout_(kDefaultRequestTimeout),
+      next_(0),
+      acquires_(0),
+      failures_(0),
+      unhealthy_(0) {}
+
+TCPClientPool::~TCPClientPool() {
+    loop_->assertInLoopThread();
+    LOG_TRACE << "TCPClientPool::~TCPClientPool [" << name_
+              << "] destructing";
+    // each client in its own loop, those are still running
+    CountDownLatch latch(static_cast<int>(slots_.size()));
+    for (auto& slot : slots_) {
+        slot->loop->runInLoop(std::bind(&TCPClientPool::destroyInLoop, this,
+                                        get_pointer(slot), &latch));
+    }
+    latch.wait();
+}
+
+void TCPClientPool::setThreadNum(int numThreads) {
+    assert(0 <= numThreads);
+    threadPool_->setThreadNum(numThreads);
+}
+
+void TCPClientPool::start() {
+    loop_->assertInLoopThread();
+    assert(slots_.empty());
+    threadPool_->start(threadInitCallback_);
+
+    const int numLoops = static_cast<int>(threadPool_->getAllLoops().size());
+    const int numConnections =
+        numConnections_ > 0 ? numConnections_ : numLoops;
+    for (int i = 0; i < numConnections; ++i) {
+        char buf[32];
+        snprintf(buf, sizeof buf, "#%d", i);
+
+        std::unique_ptr<Slot> slot(new Slot);
+        slot->loop = threadPool_->getNextLoop();
+        slot->client.reset(new TCPClient(slot->loop, serverAddr_, name_ + buf));
+        slot->connected = false;
+        slot->outstanding = 0;
+        slot->lastProgress = 0;
+
+        Slot* s = get_pointer(slot);
+        slot->client->enableRetry();
+        slot->client->setConnectionCallback(std::bind(
+            &TCPClientPool::onConnection, this, s, std::placeholders::_1));
+        slot->client->setMessageCallback(
+            std::bind(&TCPClientPool::onMessage, this, s,
+                      std::placeholders::_1, std::placeholders::_2,
+                      std::placeholders::_3));
+        slot->client->setWriteCompleteCallback(writeCompleteCallback_);
+        slots_.push_back(std::move(slot));
+    }
+
+    LOG_INFO << "TCPClientPool[" << name_ << "] - " << numConnections
+             << " connections to " << serverAddr_.toIpPort();
+    for (auto& slot : slots_) {
+        slot->client->connect();
+        slot->healthCheck = slot->loop->runEvery(
+            healthCheckInterval_,
+            std::bind(&TCPClientPool::checkHealth, this, get_pointer(slot)));
+    }
+}
+
+TCPClientPool::LeasePtr TCPClientPool::acquire() {
+    ++acquires_;
+    Slot* best = nullptr;
+    const size_t n = slots_.size();
+    if (n > 0) {
+        int bestOutstanding = INT_MAX;
+        const size_t first = next_++ % n;
+        for (size_t i = 0; i < n && bestOutstanding > 0; ++i) {
+            Slot* slot = get_pointer(slots_[(first + i) % n]);
+            if (!slot->connected) continue;
+            const int outstanding = slot->outstanding;
+            if (outstanding < bestOutstanding) {
+                best = slot;
+                bestOutstanding = outstanding;
+            }
+        }
+    }
+
+    // may have gone down meanwhile
+    TCPConnectionPtr conn = best ? best->client->connection() : nullptr;
+    if (!conn || !conn->connected()) {
+        ++failures_;
+        return LeasePtr();
+    }
+    return makeLease(best, conn);
+}
+
+TCPClientPool::Metrics TCPClientPool::metrics() const {
+    Metrics metrics = Metrics();
+    metrics.size = static_cast<int>(slots_.size());
+    for (const auto& slot : slots_) {
+        if (slot->connected) ++metrics.connected;
+        metrics.outstanding += slot->outstanding;
+    }
+    metrics.acquires = acquires_;
+    metrics.failures = failures_;
+    metrics.unhealthy = unhealthy_;
+    return metrics;
+}
+
+TCPClientPool::LeasePtr TCPClientPool::makeLease(
+    Slot* slot, const TCPConnectionPtr& conn) {
+    // the request timeout starts with the first request, not at the last
+    // progress before the connection went idle
+    if (slot->outstanding == 0) {
+        slot->lastProgress = nowIn(slot->loop).microSecondsSinceEpoch();
+    }
+    ++slot->outstanding;
+    return std::make_shared<Lease>(this, slot, conn);
+}
+
+void TCPClientPool::release(Slot* slot, const TCPConnectionPtr& conn,
+                            bool broken) {
+    slot->lastProgress = nowIn(slot->loop).microSecondsSinceEpoch();
+    --slot->outstanding;
+    if (broken) {
+        LOG_WARN << "TCPClientPool[" << name_ << "] - " << conn->name()
+                 << " is broken, reconnecting";
+        conn->forceClose();
+    }
+}
+
+void TCPClientPool::onConnection(Slot* slot, const TCPConnectionPtr& conn) {
+    slot->loop->assertInLoopThread();
+    LOG_INFO << "TCPClientPool[" << name_ << "] - " << conn->name() << " is "
+             << (conn->connected() ? "up" : "down");
+    if (conn->connected()) {
+        slot->lastProgress = slot->loop->now().microSecondsSinceEpoch();
+    }
+    slot->connected = conn->connected();
+    connectionCallback_(conn);
+}
+
+void TCPClientPool::onMessage(Slot* slot, const TCPConnectionPtr& conn,
+                              Buffer* buf, Timestamp receiveTime) {
+    slot->lastProgress = receiveTime.microSecondsSinceEpoch();
+    messageCallback_(conn, buf, receiveTime);
+}
+
+void TCPClientPool::checkHealth(Slot* slot) {
+    slot->loop->assertInLoopThread();
+    // the TCPClient connects again by itself
+    if (!slot->connected) return;
+    TCPConnectionPtr conn = slot->client->connection();
+    if (!conn) return;
+
+    const double idle = timeDifference(slot->loop->now(),
+                                       Timestamp(slot->lastProgress));
+    const int outstanding = slot->outstanding;
+    if (outstanding > 0) {
+        if (idle > requestTimeout_) {
+            LOG_WARN << "TCPClientPool[" << name_ << "] - " << conn->name()
+                     << " made no progress in " << idle << "s with "
+                     << outstanding << " requests out, reconnecting";
+            ++unhealthy_;
+            conn->forceClose();
+        }
+    } else if (healthCheckCallback_ && idle >= healthCheckInterval_) {
+        healthCheckCallback_(makeLease(slot, conn));
+    }
+}
+
+void TCPClientPool::destroyInLoop(Slot* slot, CountDownLatch* latch) {
+    slot->loop->assertInLoopThread();
+    slot->loop->cancel(slot->healthCheck);
+    TCPConnectionPtr conn = slot->client->connection();
+    if (conn) {
+        // no callbacks into the pool from here on
+        conn->setConnectionCallback(defaultConnectionCallback);
+        conn->setMessageCallback(defaultMessageCallback);
+        conn->setWriteCompleteCallback(WriteCompleteCallback());
+        // now, like ~TCPServer(), the loop may not run the functor with
+        // which ~TCPClient() closes it
+        conn->connectDestroyed();
+    }
+    slot->client.reset();
+    latch->countDown();
+}
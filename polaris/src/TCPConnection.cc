@@ -10,6 +10,7 @@
 #include <polaris/InetAddress.h>
 #include <polaris/Sockets.h>
 #include <polaris/TCPConnection.h>
+#include <poll.h>
 
 using namespace Lute;
 
@@ -42,12 +43,12 @@ TCPConnection::TCPConnection(EventLoop* loop, const std::string& name,
       channel_(new Channel(loop, sockfd)),
       localAddr_(localAddr),
       peerAddr_(perrAddr),
-      highWaterMark_(64 * 1024 * 1024) {
-    channel_->setReadCallback(
-        std::bind(&TCPConnection::handleRead, this, std::placeholders::_1));
-    channel_->setWriteCallback(std::bind(&TCPConnection::handleWrite, this));
-    channel_->setCloseCallback(std::bind(&TCPConnection::handleClose, this));
-    channel_->setErrorCallback(std::bind(&TCPConnection::handleError, this));
+      highWaterMark_(64 * 1024 * 1024),
+      flowHighMark_(0),
+      flowLowMark_(0),
+      flowPaused_(false),
+      loopConfined_(false) {
+    channel_->setEventHandler(&TCPConnection::handleEvent, this);
     LOG_DEBUG << "TCPConnection::ctor[" << name_ << "] at " << this
               << " fd=" << sockfd;
     socket_->setKeepAlive(true);
@@ -78,8 +79,11 @@ std::string TCPConnection::getTcpInfoString() const {
  * @return void: User don't care about the number of sent bytes.
  */
 void TCPConnection::send(const void* message, int len) {
-    // send(StringPiece(static_cast<const char*>(message),
-    //                  static_cast<std::basic_string<char>::size_type>(len)));
+    // in loop thread, write from caller's memory without a temporary copy
+    if (state_ == StateE::kConnected && loop_->isInLoopThread()) {
+        sendInLoop(message, static_cast<size_t>(len));
+        return;
+    }
 
     /// XXX std::sting_view
     send(std::string(static_cast<const char*>(message),
@@ -193,6 +197,10 @@ void TCPConnection::sendInLoop(const void* message, size_t len) {
         if (!channel_->isWriting()) {
             channel_->enableWriting();
         }
+        if (flowHighMark_ > 0 &&
+            outputBuffer_.readableBytes() >= flowHighMark_) {
+            pauseReadForOutput();
+        }
     }
 }
 
@@ -284,11 +292,15 @@ const char* TCPConnection::stateToString() const {
 
 void TCPConnection::setTcpNoDelay(bool on) { socket_->setTcpNoDelay(on); }
 
+void TCPConnection::setBusyPoll(int us) { socket_->setBusyPoll(us); }
+
 void TCPConnection::startRead() {
     loop_->runInLoop(std::bind(&TCPConnection::startReadInLoop, this));
 }
 void TCPConnection::startReadInLoop() {
     loop_->assertInLoopThread();
+    // the user's call wins over flow control
+    flowPaused_ = false;
     if (!reading_ || !channel_->isReading()) {
         channel_->enableReading();
         reading_ = true;
@@ -300,20 +312,61 @@ void TCPConnection::stopRead() {
 }
 void TCPConnection::stopReadInLoop() {
     loop_->assertInLoopThread();
+    flowPaused_ = false;
     if (reading_ || channel_->isReading()) {
         channel_->disableReading();
         reading_ = false;
     }
 }
 
+void TCPConnection::pauseReadForOutput() {
+    // reading stopped by the user stays stopped
+    if (flowPaused_ || !reading_) return;
+    LOG_DEBUG << "TCPConnection[" << name_ << "] stops reading, "
+              << outputBuffer_.readableBytes() << " bytes unsent";
+    channel_->disableReading();
+    reading_ = false;
+    flowPaused_ = true;
+}
+
+void TCPConnection::resumeReadForOutput() {
+    if (!flowPaused_) return;
+    flowPaused_ = false;
+    if (state_ == StateE::kConnected) {
+        LOG_DEBUG << "TCPConnection[" << name_ << "] reads again";
+        channel_->enableReading();
+        reading_ = true;
+        // input left unparsed while paused
+        if (inputBuffer_.readableBytes() > 0) {
+            loop_->queueInLoop(std::bind(&TCPConnection::redeliverInput,
+                                         shared_from_this()));
+        }
+    }
+}
+
+void TCPConnection::redeliverInput() {
+    if (state_ == StateE::kConnected && !flowPaused_ &&
+        inputBuffer_.readableBytes() > 0) {
+        TCPConnectionPtr guard;
+        messageCallback_(selfRef(&guard), &inputBuffer_, loop_->now());
+    }
+}
+
 void TCPConnection::connectEstablished() {
     loop_->assertInLoopThread();
     assert(state_ == StateE::kConnecting);
     setState(StateE::kConnected);
-    channel_->tie(shared_from_this());
+    if (loopConfined_) {
+        // covers every event, instead of channel_->tie()
+        self_ = shared_from_this();
+    } else {
+        channel_->tie(shared_from_this());
+    }
     channel_->enableReading();
+    reading_ = true;
 
-    connectionCallback_(shared_from_this());
+    TCPConnectionPtr guard;
+    connectionCallback_(selfRef(&guard));
 }
 
 void TCPConnection::connectDestroyed() {
@@ -322,19 +375,43 @@ void TCPConnection::connectDestroyed() {
         setState(StateE::kDisconnected);
         channel_->disableAll();
 
-        connectionCallback_(shared_from_this());
+        TCPConnectionPtr guard;
+        connectionCallback_(selfRef(&guard));
     }
     channel_->remove();
+    // the caller holds another reference
+    self_.reset();
+}
+
+/// Channel::handleEventWithGuard() with direct calls, in the same order.
+void TCPConnection::handleEvent(void* self, Timestamp receiveTime) {
+    TCPConnection* conn = static_cast<TCPConnection*>(self);
+    const int revents = conn->channel_->revents();
+    if ((revents & POLLHUP) && !(revents & POLLIN)) {
+        LOG_WARN << "fd = " << conn->channel_->fd()
+                 << " TCPConnection::handleEvent() POLLHUP";
+        conn->handleClose();
+    }
+    if (revents & POLLNVAL) {
+        LOG_WARN << "fd = " << conn->channel_->fd()
+                 << " TCPConnection::handleEvent() POLLNVAL";
+    }
+    if (revents & (POLLERR | POLLNVAL)) conn->handleError();
+    if (revents & (POLLIN | POLLPRI | POLLRDHUP)) conn->handleRead(receiveTime);
+    if (revents & POLLOUT) conn->handleWrite();
 }
 
 void TCPConnection::handleRead(Timestamp receiveTime) {
     loop_->assertInLoopThread();
     int savedErrno = 0;
-    ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+    // the rest is read next iteration, the channel is level triggered
+    ssize_t n =
+        inputBuffer_.readFd(channel_->fd(), &savedErrno, loop_->readBudget());
 
     // 正常读到数据
     if (n > 0) {
-        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+        TCPConnectionPtr guard;
+        messageCallback_(selfRef(&guard), &inputBuffer_, receiveTime);
     } else if (n == 0) /* 读取到文件末尾，则关闭 TCP 连接 */ {
         handleClose();
     } else /* 读取出错 */ {
@@ -356,6 +433,9 @@ void TCPConnection::handleWrite() {
             LOG_TRACE << "write " << n
                       << " bytes data to fd = " << channel_->fd();
             outputBuffer_.retrieve(static_cast<size_t>(n));
+            if (flowPaused_ && outputBuffer_.readableBytes() <= flowLowMark_) {
+                resumeReadForOutput();
+            }
             if (outputBuffer_.readableBytes() == 0) {
                 channel_->disableWriting();
                 if (writeCompleteCallback_) {
@@ -387,10 +467,17 @@ void TCPConnection::handleClose() {
     setState(StateE::kDisconnected);
     channel_->disableAll();
 
-    TCPConnectionPtr guardThis(shared_from_this());
-    connectionCallback_(guardThis);
+    TCPConnectionPtr guardThis;
+    const TCPConnectionPtr& self = selfRef(&guardThis);
+    connectionCallback_(self);
     // must be the last line
-    closeCallback_(guardThis);
+    closeCallback_(self);
+}
+
+const TCPConnectionPtr& TCPConnection::selfRef(TCPConnectionPtr* guard) {
+    if (loopConfined_) return self_;
+    *guard = shared_from_this();
+    return *guard;
 }
 
 void TCPConnection::handleError() {
@@ -15,6 +15,9 @@
 
 using namespace Lute;
 
+const size_t TCPServer::kDefaultFlowHighMark;
+const size_t TCPServer::kDefaultFlowLowMark;
+
 TCPServer::TCPServer(EventLoop* loop, const InetAddress& listenAddr,
                      const std::string& name, Option option)
     : loop_(loop),
@@ -24,6 +27,10 @@ TCPServer::TCPServer(EventLoop* loop, const InetAddress& listenAddr,
       threadPool_(new EventLoopThreadPool(loop, name_)),
       connectionCallback_(defaultConnectionCallback),
       messageCallback_(defaultMessageCallback),
+      flowHighMark_(kDefaultFlowHighMark),
+      flowLowMark_(kDefaultFlowLowMark),
+      busyPollUs_(0),
+      loopConfined_(false),
       nextConnId_(1) {
     acceptor_->setNewConnectionCallback(std::bind(&TCPServer::newConnection,
                                                   this, std::placeholders::_1,
@@ -47,9 +54,19 @@ void TCPServer::setThreadNum(int numThreads) {
     threadPool_->setThreadNum(numThreads);
 }
 
+InetAddress TCPServer::listenAddress() const {
+    return acceptor_->localAddress();
+}
+
 void TCPServer::start() {
     if (started_.getAndSet(1) == 0) {
         threadPool_->start(threadInitCallback_);
+        if (busyPollUs_ > 0) {
+            for (EventLoop* ioLoop : threadPool_->getAllLoops()) {
+                ioLoop->runInLoop(
+                    std::bind(&EventLoop::setBusyPoll, ioLoop, busyPollUs_));
+            }
+        }
 
         assert(!acceptor_->listenning());
         loop_->runInLoop(std::bind(&Acceptor::listen, get_pointer(acceptor_)));
@@ -77,6 +94,9 @@ void TCPServer::newConnection(int sockfd, const InetAddress& peerAddr) {
     conn->setConnectionCallback(connectionCallback_);
     conn->setMessageCallback(messageCallback_);
     conn->setWriteCompleteCallback(writeCompleteCallback_);
+    conn->setFlowControl(flowHighMark_, flowLowMark_);
+    if (busyPollUs_ > 0) conn->setBusyPoll(busyPollUs_);
+    conn->setLoopConfined(loopConfined_);
     conn->setCloseCallback(std::bind(&TCPServer::removeConnection, this,
                                      std::placeholders::_1));  // FIXME: unsafe
     ioLoop->runInLoop(std::bind(&TCPConnection::connectEstablished, conn));
@@ -35,9 +35,9 @@ namespace detail {
         return timerfd;
     }
 
-    struct timespec howMuchTimeFromNow(Timestamp when) {
-        int64_t microseconds = when.microSecondsSinceEpoch() -
-                               Timestamp::now().microSecondsSinceEpoch();
+    struct timespec howMuchTimeFromNow(Timestamp when, Timestamp now) {
+        int64_t microseconds =
+            when.microSecondsSinceEpoch() - now.microSecondsSinceEpoch();
         if (microseconds < 100) {
             microseconds = 100;
         }
@@ -73,7 +73,7 @@ namespace detail {
      * @param timerfd 定时器相关文件描述符
      * @param expiration 定时器相对超时时间
      */
-    void resetTimerfd(int timerfd, Timestamp expiration) {
+    void resetTimerfd(int timerfd, Timestamp expiration, Timestamp now) {
         // wake up loop by timerfd_settime()
 
         // 当new_value.it_value非0时，用于设置定时器第一次超时时间,为0代表停止定时器
@@ -85,7 +85,7 @@ namespace detail {
         memZero(&oldValue, sizeof oldValue);
 
         // - 非0时，用于设置定时器第一次超时时间,为0代表停止定时器
-        newValue.it_value = howMuchTimeFromNow(expiration);
+        newValue.it_value = howMuchTimeFromNow(expiration, now);
 
         // flags : 0 / TFD_TIMER_ABSTIME -
         // 0代表相对时间，即相对于当前时间多少，后者是绝对时间。
@@ -108,6 +108,8 @@ TimerQueue::TimerQueue(EventLoop* loop)
       timers_(),
       callingExpiredTimers_(false) {
     timerfdChannel_.setReadCallback(std::bind(&TimerQueue::handleRead, this));
+    timerfdChannel_.setHighPriority(true);
+    timerfdChannel_.setInternal(Channel::kTimerFd);
     // we are always reading the timerfd, we disarm it with timerfd_settime.
     timerfdChannel_.enableReading();
 }
@@ -138,7 +140,8 @@ void TimerQueue::addTimerInLoop(Timer* timer) {
     bool earliestChanged = insert(timer);
 
     if (earliestChanged) {
-        resetTimerfd(timerfd_, timer->expiration());
+        // may run before loop(), so not the loop's cached clock
+        resetTimerfd(timerfd_, timer->expiration(), Timestamp::now());
     }
 }
 
@@ -161,7 +164,8 @@ void TimerQueue::cancelInLoop(TimerId timerId) {
 
 void TimerQueue::handleRead() {
     loop_->assertInLoopThread();
-    Timestamp now(Timestamp::now());
+    // read when poll returned, after the timerfd alarmed
+    Timestamp now(loop_->now());
     readTimerfd(timerfd_, now);
 
     std::vector<Entry> expired = getExpired(now);
@@ -219,7 +223,7 @@ void TimerQueue::reset(const std::vector<Entry>& expired, Timestamp now) {
     }
 
     if (nextExpire.valid()) {
-        resetTimerfd(timerfd_, nextExpire);
+        resetTimerfd(timerfd_, nextExpire, now);
     }
 }
 
@@ -0,0 +1,124 @@
+#include <LuteBase.h>
+#include <LutePolaris.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace Lute;
+
+// Ping-pong latency against an echo server, with the server loop blocking
+// in epoll_wait and then busy polling. The client pauses between pings so
+// the loop goes idle, as it would at moderate load.
+//
+// BusyPoll_bench [pings] [pause us] [busy poll us]
+
+static const uint16_t kPort = 19981;
+static const size_t kMessageSize = 64;
+
+static void onMessage(const TCPConnectionPtr& conn, Buffer* buf, Timestamp) {
+    conn->send(buf);
+}
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                  sizeof addr) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return fd;
+}
+
+struct Counters {
+    int64_t hits;
+    int64_t misses;
+    int64_t sleeps;
+};
+
+/// Snapshot in the loop thread, also applies @c busyPollUs.
+static Counters setBusyPoll(EventLoop* loop, int busyPollUs) {
+    Counters c;
+    CountDownLatch latch(1);
+    loop->runInLoop([loop, busyPollUs, &c, &latch] {
+        loop->setBusyPoll(busyPollUs);
+        c = Counters{loop->spinHits(), loop->spinMisses(), loop->sleeps()};
+        latch.countDown();
+    });
+    latch.wait();
+    return c;
+}
+
+static void run(EventLoop* loop, int pings, int pauseUs, int busyPollUs) {
+    const Counters before = setBusyPoll(loop, busyPollUs);
+
+    int fd = connectTo(kPort);
+    char message[kMessageSize] = {};
+    std::vector<int64_t> rtts;
+    rtts.reserve(static_cast<size_t>(pings));
+    for (int i = 0; i < pings; ++i) {
+        if (pauseUs > 0) ::usleep(static_cast<useconds_t>(pauseUs));
+        auto start = std::chrono::steady_clock::now();
+        if (::write(fd, message, sizeof message) != sizeof message) break;
+        size_t got = 0;
+        while (got < sizeof message) {
+            ssize_t n = ::read(fd, message + got, sizeof message - got);
+            if (n <= 0) break;
+            got += static_cast<size_t>(n);
+        }
+        auto end = std::chrono::steady_clock::now();
+        rtts.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                .count());
+    }
+    ::close(fd);
+
+    const Counters after = setBusyPoll(loop, 0);
+    std::sort(rtts.begin(), rtts.end());
+    auto percentile = [&rtts](double p) {
+        size_t i = static_cast<size_t>(p * static_cast<double>(rtts.size()));
+        return static_cast<double>(rtts[std::min(i, rtts.size() - 1)]) / 1000;
+    };
+    printf("busy poll %4d us: p50 %7.1f us  p99 %7.1f us  p999 %7.1f us  "
+           "spin hits %lld misses %lld sleeps %lld\n",
+           busyPollUs, percentile(0.5), percentile(0.99), percentile(0.999),
+           static_cast<long long>(after.hits - before.hits),
+           static_cast<long long>(after.misses - before.misses),
+           static_cast<long long>(after.sleeps - before.sleeps));
+}
+
+int main(int argc, char* argv[]) {
+    const int pings = argc > 1 ? atoi(argv[1]) : 20000;
+    const int pauseUs = argc > 2 ? atoi(argv[2]) : 50;
+    const int busyPollUs = argc > 3 ? atoi(argv[3]) : 200;
+    initLogger(Logger::LogLevel::WARN);
+
+    EventLoop loop;
+    TCPServer server(&loop, InetAddress(kPort), "BusyPoll_bench");
+    server.setMessageCallback(onMessage);
+    server.start();
+
+    std::thread client([&] {
+        printf("%d pings of %zu bytes, %d us apart\n", pings, kMessageSize,
+               pauseUs);
+        run(&loop, pings, pauseUs, 0);
+        run(&loop, pings, pauseUs, busyPollUs);
+        loop.quit();
+    });
+    loop.loop();
+    client.join();
+}
@@ -0,0 +1,125 @@
+#include <LuteBase.h>
+#include <LutePolaris.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <polaris/IoUringPoller.h>
+#include <polaris/Poller.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace Lute;
+
+// Echo throughput of the epoll and io_uring pollers: client threads keep
+// many connections busy, each sends a message to all of its connections,
+// then reads all the echoes.
+//
+// Poller_bench [connections] [seconds] [client threads]
+
+static const uint16_t kPort = 19982;
+static const size_t kMessageSize = 64;
+
+static void onMessage(const TCPConnectionPtr& conn, Buffer* buf, Timestamp) {
+    conn->send(buf);
+}
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                  sizeof addr) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return fd;
+}
+
+static bool readFully(int fd, char* buf, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = ::read(fd, buf + got, len - got);
+        if (n <= 0) return false;
+        got += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static void client(int connections, double seconds,
+                   std::atomic<int64_t>* messages) {
+    std::vector<int> fds;
+    for (int i = 0; i < connections; ++i) fds.push_back(connectTo(kPort));
+
+    char message[kMessageSize] = {};
+    int64_t n = 0;
+    auto end = std::chrono::steady_clock::now() +
+               std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < end) {
+        for (int fd : fds) {
+            if (::write(fd, message, sizeof message) != sizeof message) {
+                return;
+            }
+        }
+        for (int fd : fds) {
+            if (!readFully(fd, message, sizeof message)) return;
+        }
+        n += static_cast<int64_t>(fds.size());
+    }
+    for (int fd : fds) ::close(fd);
+    *messages += n;
+}
+
+static void run(const char* name, Poller::Backend backend, int connections,
+                double seconds, int threads) {
+    Poller::setDefaultBackend(backend);
+    EventLoop loop;
+    TCPServer server(&loop, InetAddress(kPort), name);
+    server.setMessageCallback(onMessage);
+    server.start();
+
+    std::atomic<int64_t> messages(0);
+    std::thread clients([&] {
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threads; ++i) {
+            workers.emplace_back(client, connections / threads, seconds,
+                                 &messages);
+        }
+        for (std::thread& worker : workers) worker.join();
+        loop.quit();
+    });
+    loop.loop();
+    clients.join();
+
+    printf("%-8s %d connections: %.0f messages/s, %lld iterations, "
+           "%lld poller updates, %lld saved\n",
+           name, connections, static_cast<double>(messages.load()) / seconds,
+           static_cast<long long>(loop.iteration()),
+           static_cast<long long>(loop.pollerUpdates()),
+           static_cast<long long>(loop.pollerUpdatesSaved()));
+}
+
+int main(int argc, char* argv[]) {
+    const int connections = argc > 1 ? atoi(argv[1]) : 256;
+    const double seconds = argc > 2 ? atof(argv[2]) : 3.0;
+    const int threads = argc > 3 ? atoi(argv[3]) : 4;
+    initLogger(Logger::LogLevel::WARN);
+
+    run("epoll", Poller::Backend::kEPoll, connections, seconds, threads);
+    if (IoUringPoller::supported()) {
+        run("io_uring", Poller::Backend::kIoUring, connections, seconds,
+            threads);
+    } else {
+        printf("io_uring is not supported\n");
+    }
+}
@@ -0,0 +1,85 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Cost of handing a connection to its message callback, the way
+// TCPConnection does by default (Channel::tie() guard plus
+// shared_from_this(), both atomic) and in loop-confined mode (a reference
+// to its own self_).
+// Other threads copy the same shared_ptr meanwhile, as worker threads that
+// send on a connection do, so the reference count bounces between cores.
+//
+// Refcount_bench [dispatches] [max contending threads]
+
+struct Connection : std::enable_shared_from_this<Connection> {
+    std::function<void(const std::shared_ptr<Connection>&, size_t)> callback;
+    std::shared_ptr<Connection> self;
+    std::weak_ptr<void> tie;
+    size_t bytes = 0;
+};
+
+static void onMessage(const std::shared_ptr<Connection>& conn, size_t n) {
+    conn->bytes += n;
+}
+
+static void tiedDispatch(Connection* conn, size_t n) {
+    std::shared_ptr<void> guard = conn->tie.lock();
+    if (guard) conn->callback(conn->shared_from_this(), n);
+}
+
+static void borrowedDispatch(Connection* conn, size_t n) {
+    conn->callback(conn->self, n);
+}
+
+static double run(void (*dispatch)(Connection*, size_t), int64_t dispatches,
+                  int contenders) {
+    std::shared_ptr<Connection> conn = std::make_shared<Connection>();
+    conn->callback = onMessage;
+    conn->self = conn;
+    conn->tie = conn;
+
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < contenders; ++i) {
+        threads.emplace_back([&conn, &stop] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::shared_ptr<Connection> copy(conn);
+                (void)copy;
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < dispatches; ++i) {
+        dispatch(conn.get(), 1);
+    }
+    auto end = std::chrono::steady_clock::now();
+    stop = true;
+    for (std::thread& thread : threads) thread.join();
+
+    if (conn->bytes != static_cast<size_t>(dispatches)) abort();
+    conn->self.reset();
+    return static_cast<double>(
+               std::chrono::duration_cast<std::chrono::nanoseconds>(end -
+                                                                    start)
+                   .count()) /
+           static_cast<double>(dispatches);
+}
+
+int main(int argc, char* argv[]) {
+    const int64_t dispatches = argc > 1 ? atoll(argv[1]) : 10000000;
+    const int maxContenders = argc > 2 ? atoi(argv[2]) : 2;
+
+    for (int contenders = 0; contenders <= maxContenders; ++contenders) {
+        const double tied = run(tiedDispatch, dispatches, contenders);
+        const double borrowed = run(borrowedDispatch, dispatches, contenders);
+        printf("%d contending threads: tie + shared_from_this %6.1f ns, "
+               "borrowed %6.1f ns per dispatch\n",
+               contenders, tied, borrowed);
+    }
+}
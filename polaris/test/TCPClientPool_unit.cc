@@ -0,0 +1,139 @@
+#include <LuteBase.h>
+#include <LutePolaris.h>
+
+#include <cstdio>
+#include <deque>
+#include <map>
+
+using namespace Lute;
+
+// A pool of connections to an echo server in the same process: requests are
+// spread over the connections, then the server stops answering and the
+// health check reconnects them. Exits with 1 if a reply is missing or a
+// stalled connection is not reconnected.
+//
+// TCPClientPool_unit [connections] [threads] [requests]
+
+using LeaseQueue = std::deque<TCPClientPool::LeasePtr>;
+
+static bool serverStalled = false;
+static int numReplies = 0;
+static std::map<std::string, int> repliesPerConnection;
+static bool failed = false;
+
+static void onServerMessage(const TCPConnectionPtr& conn, Buffer* buf,
+                            Timestamp) {
+    if (serverStalled) {
+        buf->retrieveAll();
+        return;
+    }
+    conn->send(buf);
+}
+
+static void onConnection(const TCPConnectionPtr& conn) {
+    // replies come back in order, so do their leases; down, they are dropped
+    conn->setContext(LeaseQueue());
+}
+
+static void onMessage(EventLoop* loop, const TCPConnectionPtr& conn,
+                      Buffer* buf, Timestamp) {
+    LeaseQueue* leases = Lute::any_cast<LeaseQueue>(conn->getMutableContext());
+    for (const char* eol = buf->findEOL(); eol; eol = buf->findEOL()) {
+        buf->retrieveUntil(eol + 1);
+        if (leases->empty()) continue;
+        // gives the connection back to the pool
+        leases->pop_front();
+        const std::string name = conn->name();
+        loop->queueInLoop([name] {
+            ++numReplies;
+            ++repliesPerConnection[name];
+        });
+    }
+}
+
+static void request(const TCPClientPool::LeasePtr& lease) {
+    lease->getLoop()->runInLoop([lease] {
+        const TCPConnectionPtr& conn = lease->connection();
+        if (!conn->connected()) return;
+        Lute::any_cast<LeaseQueue>(conn->getMutableContext())
+            ->push_back(lease);
+        conn->send("ping\n");
+    });
+}
+
+static TCPClientPool::Metrics printMetrics(const char* when,
+                                           const TCPClientPool& pool) {
+    TCPClientPool::Metrics m = pool.metrics();
+    printf("%s: %d connections, %d connected, %d outstanding, "
+           "%lld acquires, %lld failures, %lld unhealthy\n",
+           when, m.size, m.connected, m.outstanding,
+           static_cast<long long>(m.acquires),
+           static_cast<long long>(m.failures),
+           static_cast<long long>(m.unhealthy));
+    return m;
+}
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        printf("FAILED: %s\n", what);
+        failed = true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const int connections = argc > 1 ? atoi(argv[1]) : 6;
+    const int threads = argc > 2 ? atoi(argv[2]) : 2;
+    const int requests = argc > 3 ? atoi(argv[3]) : 10000;
+    initLogger(Logger::LogLevel::WARN);
+
+    EventLoop loop;
+    // any free port
+    TCPServer server(&loop, InetAddress(0, true), "TCPClientPool_server");
+    server.setMessageCallback(onServerMessage);
+    server.start();
+
+    const uint16_t port = server.listenAddress().toPort();
+    TCPClientPool pool(&loop, InetAddress("127.0.0.1", port),
+                       "TCPClientPool_unit");
+    pool.setThreadNum(threads);
+    pool.setConnectionNum(connections);
+    pool.setHealthCheck(0.2, 0.5, TCPClientPool::HealthCheckCallback());
+    pool.setConnectionCallback(onConnection);
+    pool.setMessageCallback(std::bind(onMessage, &loop, std::placeholders::_1,
+                                      std::placeholders::_2,
+                                      std::placeholders::_3));
+    pool.start();
+
+    loop.runAfter(0.5, [&] {
+        printMetrics("connected", pool);
+        for (int i = 0; i < requests; ++i) {
+            TCPClientPool::LeasePtr lease = pool.acquire();
+            if (lease) request(lease);
+        }
+    });
+    loop.runAfter(1.5, [&] {
+        printf("%d replies of %d requests\n", numReplies, requests);
+        for (const auto& item : repliesPerConnection) {
+            printf("  %s: %d\n", item.first.c_str(), item.second);
+        }
+        TCPClientPool::Metrics m = printMetrics("served", pool);
+        check(numReplies == requests, "a reply for every request");
+        check(m.failures == 0, "no acquire without a connection");
+
+        serverStalled = true;
+        for (int i = 0; i < connections; ++i) {
+            TCPClientPool::LeasePtr lease = pool.acquire();
+            if (lease) request(lease);
+        }
+    });
+    loop.runAfter(1.7, [&] { printMetrics("stalled", pool); });
+    loop.runAfter(3.0, [&] {
+        TCPClientPool::Metrics m = printMetrics("reconnected", pool);
+        check(m.unhealthy == connections, "every stalled connection closed");
+        check(m.connected == connections, "every connection up again");
+        check(m.outstanding == 0, "every lease given back");
+        loop.quit();
+    });
+    loop.loop();
+    return failed ? 1 : 0;
+}